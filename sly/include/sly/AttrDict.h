@@ -7,7 +7,9 @@
 
 #include <any>
 #include <cassert>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <map>
 #include <functional>
@@ -21,6 +23,26 @@
 using namespace std;
 
 namespace sly::core::type{
+
+/**
+ * 词法单元的起始行列号（从 1 开始）
+ */
+struct SourceLocation {
+  uint32_t row;
+  uint32_t col;
+};
+
+/**
+ * 按字节偏移求行列号，由扫描器实现
+ */
+class SourceLocator {
+ public:
+  virtual SourceLocation Locate(size_t offset) = 0;
+
+ protected:
+  ~SourceLocator() = default;
+};
+
 class AttrDict
 {
  public:
@@ -44,12 +66,57 @@ class AttrDict
   
   inline void Clear();
 
+  /**
+   * 记录词文与位置，不经过 map 和 any，也不拷贝词文。
+   * text 指向扫描器的输入缓冲区，使用期间缓冲区必须保持有效。
+   * 之后 Get<string>("lval")、Get<int>("row")、Get<int>("col") 仍然可用。
+   * @param text
+   * @param location
+   */
+  inline void SetLexeme(std::string_view text, SourceLocation location);
+
+  /**
+   * 只记录词文与字节偏移，行列号在第一次 GetLocation()（或读取 row / col）时
+   * 才由 locator 求出，不查询位置的词法单元不会建立行首索引。
+   * 在此之前 locator 必须保持有效，且不能切换到其他输入。
+   * @param text
+   * @param offset
+   * @param locator
+   */
+  inline void SetLexeme(std::string_view text, size_t offset,
+                        SourceLocator *locator);
+
+  inline bool HasLexeme() const;
+
+  inline std::string_view GetLexeme() const;
+
+  inline const SourceLocation &GetLocation() const;
+
   map<string, string> ToStrDict() const;
 
   string ToString() const;
  
  private:
+  /**
+   * 从 SetLexeme 记录的词文与位置中读取 lval / row / col
+   * @param attr_name
+   * @return
+   */
+  template<typename T>
+  std::optional<T> GetInline(const std::string& attr_name) const;
+
   map<string, any> attr_dict_;
+
+  std::string_view lexeme_;
+
+  mutable SourceLocation location_{};
+
+  // 非空时 location_ 尚未求出
+  mutable SourceLocator *locator_ = nullptr;
+
+  size_t offset_ = 0;
+
+  bool has_lexeme_ = false;
 };
 
 extern map<std::type_index, function<std::string(const any& v)>> type_registery;
@@ -76,6 +143,8 @@ T AttrDict::Get(const std::string& attr_name) const
   // check attr_name available:
   auto i = attr_dict_.find(attr_name);
   if (i == attr_dict_.end()){
+    if (auto inline_value = GetInline<T>(attr_name); inline_value.has_value())
+      return *inline_value;
     spdlog::error("cannot find attribute[[{}]].", attr_name);
     throw runtime_error(fmt::format("cannot find attribute[[{}]].", attr_name));
   }
@@ -93,7 +162,7 @@ bool AttrDict::Has(const std::string& attr_name) const
   // check attr_name available:
   auto i = attr_dict_.find(attr_name);
   if (i == attr_dict_.end())
-    return false;
+    return GetInline<T>(attr_name).has_value();
   else
     return i->second.type() == typeid(T);
 }
@@ -167,9 +236,63 @@ void AttrDict::Set(string attr_name, T attr_value)
 }
 
 
+template<typename T>
+std::optional<T> AttrDict::GetInline(const std::string& attr_name) const
+{
+  if (!has_lexeme_)
+    return std::nullopt;
+  if constexpr (std::is_same_v<T, std::string>) {
+    if (attr_name == "lval")
+      return std::string(lexeme_);
+  } else if constexpr (std::is_same_v<T, int>) {
+    if (attr_name == "row")
+      return static_cast<int>(GetLocation().row);
+    if (attr_name == "col")
+      return static_cast<int>(GetLocation().col);
+  }
+  return std::nullopt;
+}
+
 inline void AttrDict::Clear()
 {
   attr_dict_.clear();
+  has_lexeme_ = false;
+}
+
+inline void AttrDict::SetLexeme(std::string_view text, SourceLocation location)
+{
+  lexeme_ = text;
+  location_ = location;
+  locator_ = nullptr;
+  has_lexeme_ = true;
+}
+
+inline void AttrDict::SetLexeme(std::string_view text, size_t offset,
+                                SourceLocator *locator)
+{
+  lexeme_ = text;
+  offset_ = offset;
+  locator_ = locator;
+  has_lexeme_ = true;
+}
+
+inline bool AttrDict::HasLexeme() const
+{
+  return has_lexeme_;
+}
+
+inline std::string_view AttrDict::GetLexeme() const
+{
+  return lexeme_;
+}
+
+inline const SourceLocation &AttrDict::GetLocation() const
+{
+  if (locator_ != nullptr) {
+    location_ = locator_->Locate(offset_);
+    locator_ = nullptr;
+  }
+  return location_;
 }
 }
 
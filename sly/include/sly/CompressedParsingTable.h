@@ -0,0 +1,144 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#ifndef SEULEXYACC_COMPRESSEDPARSINGTABLE_H
+#define SEULEXYACC_COMPRESSEDPARSINGTABLE_H
+#include "def.h"
+#include "Token.h"
+#include "DenseParsingTable.h"
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace sly::core::grammar {
+
+/**
+ * 压缩的分析表（与 bison 的 yypact/yydefact/yytable/yycheck 相同的组织方式）：
+ * - 每个状态选出现最多的规约作为默认动作，ACTION 行中与默认动作相同的格子以及错误格子都不再保存；
+ * - 每个非终结符选出现最多的目标状态作为默认 GOTO，GOTO 按列保存；
+ * - 剩余的行/列以不同的位移叠放进同一个 table_，check_ 记录格子属于哪个下标；
+ * - 内容相同的行/列共用同一个位移。
+ * 默认规约会推迟错误的发现，但不会在出错的 token 上执行移入。
+ */
+class CompressedParsingTable {
+ public:
+  using Cell = DenseParsingTable::Cell;
+
+  CompressedParsingTable() = default;
+
+  explicit CompressedParsingTable(const DenseParsingTable &dense);
+
+  int SymbolOf(const Token &tok) const {
+    auto f = symbol_id_.find(tok);
+    return f == symbol_id_.end() ? -1 : f->second;
+  }
+
+  /**
+   * 状态只有一个默认规约时返回产生式编号，此时不需要查看向前看符号；否则返回 -1
+   * @param state
+   * @return
+   */
+  int GetForcedReduction(IdType state) const {
+    return action_base_[state] == kNoBase ? default_reduction_[state] : -1;
+  }
+
+  Cell GetAction(IdType state, int symbol) const {
+    int base = action_base_[state];
+    if (base != kNoBase) {
+      long i = static_cast<long>(base) + symbol;
+      if (i >= 0 && i < static_cast<long>(check_.size()) && check_[i] == symbol)
+        return DenseParsingTable::Decode(table_[i]);
+    }
+    return DenseParsingTable::Decode(default_action_[state]);
+  }
+
+  /**
+   * 返回 GOTO 的目标状态，不存在时返回 -1
+   * @param state
+   * @param symbol 非终结符编号
+   * @return
+   */
+  int GetGoto(IdType state, int symbol) const {
+    size_t nt = symbol - n_terminators_;
+    int base = goto_base_[nt];
+    if (base != kNoBase) {
+      long i = static_cast<long>(base) + static_cast<long>(state);
+      if (i >= 0 && i < static_cast<long>(check_.size()) &&
+          check_[i] == static_cast<int>(state))
+        return static_cast<int>(table_[i]);
+    }
+    return default_goto_[nt];
+  }
+
+  int GetLhs(IdType prod) const { return lhs_[prod]; }
+
+  size_t GetRhsLength(IdType prod) const { return rhs_length_[prod]; }
+
+  size_t GetStateCount() const { return action_base_.size(); }
+
+  /**
+   * table_ 与 check_ 的长度
+   */
+  size_t GetPackedSize() const { return table_.size(); }
+
+  /**
+   * 与之前某一行/列内容相同、直接共用位移的行/列数
+   */
+  size_t GetSharedVectorCount() const { return shared_vector_count_; }
+
+  /**
+   * 只有默认规约的状态数
+   */
+  size_t GetForcedReductionCount() const;
+
+ private:
+  static constexpr int kNoBase = INT_MIN;
+
+  /**
+   * 把一行/列 {下标, 值} 放进 table_，返回位移
+   * @param entries 按下标升序
+   * @param used_base 已被占用的位移
+   * @param low_free table_ 中第一个空位，用于加速查找
+   * @return
+   */
+  int Pack(const vector<pair<int, uint32_t>> &entries,
+           unordered_set<int> &used_base, size_t &low_free);
+
+  size_t n_terminators_ = 0;
+
+  unordered_map<Token, int, Token::Hash> symbol_id_;
+
+  // yypact：ACTION 行的位移，kNoBase 表示整行都是默认动作
+  vector<int> action_base_;
+
+  // yydefact：每个状态的默认动作（规约或错误）
+  vector<uint32_t> default_action_;
+
+  // 默认动作为规约时的产生式编号，否则为 -1
+  vector<int> default_reduction_;
+
+  // yypgoto：GOTO 列的位移
+  vector<int> goto_base_;
+
+  // yydefgoto：每个非终结符的默认目标状态
+  vector<int> default_goto_;
+
+  // yytable
+  vector<uint32_t> table_;
+
+  // yycheck，-1 为空位
+  vector<int> check_;
+
+  vector<int> lhs_;
+
+  vector<size_t> rhs_length_;
+
+  size_t shared_vector_count_ = 0;
+};
+
+}
+
+#endif //SEULEXYACC_COMPRESSEDPARSINGTABLE_H
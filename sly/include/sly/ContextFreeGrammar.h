@@ -23,7 +23,8 @@ class LRItem {
   
   explicit LRItem(Production::TokenVec tos,
                   Production::TokenSet las,
-                  size_t cur_pos = 0);
+                  size_t cur_pos = 0,
+                  optional<IdType> prod_id = {});
   
   bool operator==(const LRItem &rhs) const;
   
@@ -41,6 +42,12 @@ class LRItem {
    */
   size_t GetCurrentPosition() const;
   
+  /**
+   * 返回项目所属产生式的编号，构造时未给出则为空
+   * @return
+   */
+  optional<IdType> GetProductionId() const;
+  
   optional<Token> Next() const;
   
   bool CanReduce() const;
@@ -58,6 +65,8 @@ class LRItem {
   Production::TokenSet look_ahead_;
   
   size_t current_position_;
+  
+  optional<IdType> production_id_;
 };
 
 using LRItemSet = std::unordered_set<LRItem, LRItem::Hash>;
@@ -92,7 +101,7 @@ class ContextFreeGrammar {
   const ParsingTable &GetLrTable() const;
   
   /**
-   * 查找production
+   * 查找production，有多个 token 序列相同的产生式时返回编号最小的
    * @param token_vec
    * @return
    */
@@ -142,6 +151,10 @@ class ContextFreeGrammar {
   
   unordered_map<Token, vector<IdType>, Token::Hash> tok_prod_id_map_;
   
+  unordered_set<Token, Token::Hash> terminator_set_;
+  
+  unordered_map<Production::TokenVec, IdType, Production::TokenVecHash> prod_id_map_;
+  
   Token entry_token_;
   
   Token augmented_token_;
@@ -0,0 +1,116 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#ifndef SEULEXYACC_DENSEPARSINGTABLE_H
+#define SEULEXYACC_DENSEPARSINGTABLE_H
+#include "def.h"
+#include "Token.h"
+#include "TableGenerateMethod.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace sly::core::grammar {
+
+/**
+ * 运行时使用的稠密分析表：终结符与非终结符连续编号，
+ * ACTION 与 GOTO 共用一个 states × symbols 的整数数组，查询时不做散列也不分配内存。
+ *
+ * 每个格子编码为 (id << 3) | action，action 取 ParsingTable::AutomataAction：
+ * 移入与 GOTO 的 id 为目标状态，规约的 id 为产生式编号，
+ * 原表中一个格子有多个动作时记为 kEmpty。
+ */
+class DenseParsingTable {
+ public:
+  struct Cell {
+    ParsingTable::AutomataAction action;
+    IdType id;
+  };
+
+  DenseParsingTable() = default;
+
+  explicit DenseParsingTable(const ParsingTable &table);
+
+  /**
+   * 返回 token 的编号，不在表中时返回 -1
+   * @param tok
+   * @return
+   */
+  int SymbolOf(const Token &tok) const {
+    auto f = symbol_id_.find(tok);
+    return f == symbol_id_.end() ? -1 : f->second;
+  }
+
+  Cell GetAction(IdType state, int symbol) const {
+    return Decode(cells_[state * n_symbols_ + symbol]);
+  }
+
+  /**
+   * 返回 GOTO 的目标状态，不存在时返回 -1
+   * @param state
+   * @param symbol 非终结符编号
+   * @return
+   */
+  int GetGoto(IdType state, int symbol) const {
+    uint32_t code = cells_[state * n_symbols_ + symbol];
+    if ((code & kActionMask) != ParsingTable::kShiftIn)
+      return -1;
+    return static_cast<int>(code >> kActionBits);
+  }
+
+  /**
+   * 产生式左部的编号
+   */
+  int GetLhs(IdType prod) const { return lhs_[prod]; }
+
+  /**
+   * 产生式右部的长度
+   */
+  size_t GetRhsLength(IdType prod) const { return rhs_length_[prod]; }
+
+  size_t GetStateCount() const { return n_states_; }
+
+  /**
+   * 编号 [0, GetTerminatorCount()) 为终结符，其余为非终结符
+   */
+  size_t GetTerminatorCount() const { return n_terminators_; }
+
+  size_t GetSymbolCount() const { return n_symbols_; }
+
+  size_t GetProductionCount() const { return lhs_.size(); }
+
+  const vector<Token> &GetSymbols() const;
+
+  static uint32_t Encode(ParsingTable::AutomataAction action, IdType id);
+
+  static Cell Decode(uint32_t code) {
+    return Cell{static_cast<ParsingTable::AutomataAction>(code & kActionMask),
+                code >> kActionBits};
+  }
+
+ private:
+  static constexpr uint32_t kActionBits = 3;
+
+  static constexpr uint32_t kActionMask = (1u << kActionBits) - 1;
+
+  size_t n_states_ = 0;
+
+  size_t n_terminators_ = 0;
+
+  size_t n_symbols_ = 0;
+
+  vector<Token> symbols_;
+
+  unordered_map<Token, int, Token::Hash> symbol_id_;
+
+  vector<uint32_t> cells_;
+
+  vector<int> lhs_;
+
+  vector<size_t> rhs_length_;
+};
+
+}
+
+#endif //SEULEXYACC_DENSEPARSINGTABLE_H
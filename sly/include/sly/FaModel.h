@@ -120,6 +120,8 @@ NfaModel operator *(const NfaModel& na, const NfaModel& nb);
 NfaModel operator ++(const NfaModel& na);
 
 
+class MergedDfaModel;
+
 class DfaModel
 {
  public:
@@ -152,6 +154,7 @@ class DfaModel
   CStyleTable ToCTable() const;
  
  private:
+  friend class MergedDfaModel;
   
   // charset
   set<char> charset_;
@@ -163,6 +166,72 @@ class DfaModel
   vector<map<char, int>> transition_;
 };
 
+/**
+ * 多条规则合并后的 DFA（与 DfaModel::Merge 的结果一致），保留乘积状态，
+ * 以便在增加、删除或替换单条规则时只重新确定化受影响的乘积状态。
+ * 目前只有内存中的接口：生成器产生的程序启动时仍用 DfaModel::Merge 合并全部规则，
+ * .l 文件在两次生成之间的改动还不会经过这里。
+ */
+class MergedDfaModel
+{
+ public:
+  explicit MergedDfaModel(std::vector<DfaModel> dfa_list);
+
+  MergedDfaModel() = default;
+
+  /**
+   * 在末尾添加一条规则（优先级最低）
+   * @param dfa
+   */
+  void AddRule(DfaModel dfa);
+
+  /**
+   * 在 pos 处插入一条规则，之后的规则优先级顺延
+   * @param pos
+   * @param dfa
+   */
+  void InsertRule(size_t pos, DfaModel dfa);
+
+  void RemoveRule(size_t pos);
+
+  void ReplaceRule(size_t pos, DfaModel dfa);
+
+ public: // Getters
+  const vector<vector<int>> &GetTransition() const;
+
+  const vector<int> &GetAcceptStates() const;
+
+  const vector<DfaModel> &GetDfaList() const;
+
+  /**
+   * 最近一次构建或更新中，需要查询规则 DFA 重新确定化的状态数
+   * @return
+   */
+  size_t GetRederivedCount() const;
+
+ private:
+  /**
+   * 以除 pos 以外的规则构成的投影自动机为基础，重新推导第 pos 条规则
+   * @param pos 规则位置（新编号）
+   * @param p_dfa 新的规则，nullptr 表示删除
+   * @param had_old 旧的乘积状态中是否含有第 pos 个分量
+   */
+  void Rederive(size_t pos, const DfaModel *p_dfa, bool had_old);
+
+  int DetermineAccept(const vector<int> &state) const;
+
+  vector<DfaModel> dfa_list_;
+
+  // states_[i][j] 为乘积状态 i 中第 j 条规则的状态，-1 表示已退出
+  vector<vector<int>> states_;
+
+  vector<vector<int>> transition_;
+
+  vector<int> accept_;
+
+  size_t rederived_count_ = 0;
+};
+
 class DfaController
 {
  public:
@@ -0,0 +1,227 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#ifndef SEULEXYACC_GRAMMARINDEX_H
+#define SEULEXYACC_GRAMMARINDEX_H
+#include "def.h"
+#include "Token.h"
+#include "ContextFreeGrammar.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace sly::core::grammar {
+
+/**
+ * 终结符集合，按终结符编号存为位串
+ */
+class TerminalSet {
+ public:
+  TerminalSet() = default;
+
+  explicit TerminalSet(size_t n_terminators)
+      : words_((n_terminators + 63) / 64, 0) {}
+
+  void Set(size_t t) { words_[t >> 6] |= uint64_t(1) << (t & 63); }
+
+  bool Test(size_t t) const { return words_[t >> 6] >> (t & 63) & 1; }
+
+  /**
+   * 并入 other，返回是否加入了新的终结符
+   * @param other
+   * @return
+   */
+  bool Merge(const TerminalSet &other) {
+    bool changed = false;
+    for (size_t w = 0; w < words_.size(); ++w) {
+      uint64_t merged = words_[w] | other.words_[w];
+      changed = changed || merged != words_[w];
+      words_[w] = merged;
+    }
+    return changed;
+  }
+
+  bool Intersects(const TerminalSet &other) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      if (words_[w] & other.words_[w])
+        return true;
+    }
+    return false;
+  }
+
+  bool IsSubsetOf(const TerminalSet &other) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      if (words_[w] & ~other.words_[w])
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * 只比较 mask 中的终结符
+   */
+  bool EqualsOn(const TerminalSet &other, const TerminalSet &mask) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      if ((words_[w] ^ other.words_[w]) & mask.words_[w])
+        return false;
+    }
+    return true;
+  }
+
+  bool Empty() const {
+    for (auto w : words_) {
+      if (w)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * 按编号升序对每个终结符调用 f
+   */
+  template <typename F> void ForEach(F f) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      for (uint64_t bits = words_[w]; bits; bits &= bits - 1)
+        f(w * 64 + __builtin_ctzll(bits));
+    }
+  }
+
+  bool operator==(const TerminalSet &rhs) const { return words_ == rhs.words_; }
+
+  bool operator<(const TerminalSet &rhs) const { return words_ < rhs.words_; }
+
+  struct Hash {
+    std::size_t operator()(const TerminalSet &k) const {
+      size_t hv = 0;
+      for (auto w : k.words_)
+        hv = hv * 1000003 ^ std::hash<uint64_t>{}(w);
+      return hv;
+    }
+  };
+
+ private:
+  vector<uint64_t> words_;
+};
+
+/**
+ * DeRemer–Pennello 的 digraph 算法：若 x 与 y 有关系（relation[x] 含 y），则
+ * sets[x] 包含 sets[y]。按强连通分量的逆拓扑序传播，每条边只合并一次，
+ * 同一强连通分量中的元素得到相同的集合。
+ * @param relation
+ * @param sets 输入为初始集合，输出为传递闭包
+ */
+void Digraph(const vector<vector<int>> &relation, vector<TerminalSet> &sets);
+
+/**
+ * 文法的整数表示，供各 TableGenerateMethod 使用：
+ * 终结符编号在前、非终结符在后，产生式右部为符号编号（不含 epsilon），
+ * 并预先求出可空性、每个符号的 FIRST / FOLLOW 集，
+ * 以及每个产生式右部每个后缀的 FIRST 集。
+ */
+class GrammarIndex {
+ public:
+  // LR 项目：(产生式编号, 圆点前的右部符号数)
+  using Item = pair<IdType, size_t>;
+
+  explicit GrammarIndex(const ContextFreeGrammar &cfg);
+
+  size_t GetTerminatorCount() const { return n_terminators_; }
+
+  size_t GetSymbolCount() const { return symbols_.size(); }
+
+  size_t GetProductionCount() const { return lhs_.size(); }
+
+  bool IsTerminator(int symbol) const {
+    return symbol < static_cast<int>(n_terminators_);
+  }
+
+  int SymbolOf(const Token &tok) const { return symbol_id_.at(tok); }
+
+  const Token &TokenOf(int symbol) const { return symbols_[symbol]; }
+
+  int GetLhs(IdType prod) const { return lhs_[prod]; }
+
+  const vector<int> &GetRhs(IdType prod) const { return rhs_[prod]; }
+
+  /**
+   * 非终结符 symbol 的全部产生式
+   */
+  const vector<IdType> &GetProductionsOf(int symbol) const {
+    return prods_of_[symbol - n_terminators_];
+  }
+
+  bool IsNullable(int symbol) const { return nullable_[symbol]; }
+
+  const TerminalSet &GetFirst(int symbol) const { return first_[symbol]; }
+
+  /**
+   * FOLLOW 集，增广文法的开始符号含结束符
+   */
+  const TerminalSet &GetFollow(int symbol) const { return follow_[symbol]; }
+
+  /**
+   * FIRST(rhs[pos..])，pos 可以等于右部长度
+   */
+  const TerminalSet &GetFirst(IdType prod, size_t pos) const {
+    return suffix_first_[suffix_offset_[prod] + pos];
+  }
+
+  /**
+   * rhs[pos..] 是否可空
+   */
+  bool IsNullable(IdType prod, size_t pos) const {
+    return suffix_nullable_[suffix_offset_[prod] + pos];
+  }
+
+  /**
+   * 转换为 GenTable 使用的 LRItem；epsilon 产生式只有可规约项目
+   * @param prod
+   * @param dot 圆点前的右部符号数
+   * @param look_ahead
+   * @return
+   */
+  LRItem MakeItem(IdType prod, size_t dot, const TerminalSet &look_ahead) const;
+
+  /**
+   * 求 LR(1) 闭包，返回项目及其向前看符号，核心项目在前
+   * @param kernel
+   * @param look_ahead 与 kernel 一一对应
+   * @return
+   */
+  vector<pair<Item, TerminalSet>>
+  Lr1Closure(const vector<Item> &kernel,
+             const vector<TerminalSet> &look_ahead) const;
+
+ private:
+  const ContextFreeGrammar &cfg_;
+
+  size_t n_terminators_ = 0;
+
+  vector<Token> symbols_;
+
+  unordered_map<Token, int, Token::Hash> symbol_id_;
+
+  vector<int> lhs_;
+
+  vector<vector<int>> rhs_;
+
+  vector<vector<IdType>> prods_of_;
+
+  vector<bool> nullable_;
+
+  vector<TerminalSet> first_;
+
+  vector<TerminalSet> follow_;
+
+  // 产生式 p 的后缀 rhs[pos..] 位于 suffix_offset_[p] + pos
+  vector<size_t> suffix_offset_;
+
+  vector<TerminalSet> suffix_first_;
+
+  vector<bool> suffix_nullable_;
+};
+
+}
+
+#endif //SEULEXYACC_GRAMMARINDEX_H
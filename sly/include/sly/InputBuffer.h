@@ -0,0 +1,59 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#ifndef SEULEXYACC_INPUTBUFFER_H
+#define SEULEXYACC_INPUTBUFFER_H
+#include <cstddef>
+#include <istream>
+#include <vector>
+
+
+namespace sly::runtime {
+
+constexpr size_t LEX_BUFFER_SIZE = 4096;
+
+/**
+ * 流式输入缓冲区（flex 风格）：固定容量的缓冲区，有效数据之后总有一个 '\0' 哨兵。
+ * 扫描器只有在读到哨兵时才需要调用 Refill，未扫描完的词法单元会被搬到缓冲区开头保留。
+ * 只有单个词法单元超过容量时缓冲区才会扩容，因此内存占用与输入大小无关。
+ */
+class InputBuffer {
+ public:
+  explicit InputBuffer(std::istream *in, size_t capacity = LEX_BUFFER_SIZE);
+
+  const char *Data() const;
+
+  char *Data();
+
+  /**
+   * 有效数据长度，Data()[Size()] 为哨兵
+   * @return
+   */
+  size_t Size() const;
+
+  size_t Capacity() const;
+
+  /**
+   * 丢弃 [0, keep) 的数据，其余数据移到开头，并从输入流读入新数据
+   * @param keep 需要保留的第一个字节（通常是当前词法单元的起点）
+   * @return 新读入的字节数，0 表示输入结束
+   */
+  size_t Refill(size_t keep);
+
+  bool Eof() const;
+
+ private:
+  std::istream *in_;
+
+  // 容量 + 1 个字节的哨兵
+  std::vector<char> data_;
+
+  size_t size_ = 0;
+
+  bool eof_ = false;
+};
+
+}
+
+#endif //SEULEXYACC_INPUTBUFFER_H
@@ -0,0 +1,121 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#ifndef SEULEXYACC_KEYWORDTABLE_H
+#define SEULEXYACC_KEYWORDTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "FaModel.h"
+
+
+namespace sly::runtime {
+
+/**
+ * 关键字表：对一组固定的字符串构造完美散列，查询时只计算一次散列并比较一次。
+ * 用于代替 DFA 中逐个展开的关键字规则：DFA 只识别标识符，匹配后再查表重新分类。
+ */
+class KeywordTable {
+ public:
+  KeywordTable() = default;
+
+  /**
+   * @param keywords {关键字, 规则编号}，关键字非空且互不相同，否则抛出 runtime_error
+   */
+  explicit KeywordTable(const std::vector<std::pair<std::string, int>> &keywords);
+
+  /**
+   * 从规则中分离出关键字规则：只接受一个字符串，且该字符串也被 rules 中另一条规则接受。
+   * 这样的规则从 DFA 中去掉后，接受状态与最长匹配的长度都不变，
+   * 只需在匹配后按 Reclassify() 恢复优先级。
+   * @param dfa_list 全部规则
+   * @param rules 参与合并的规则（dfa_list 的下标，按优先级升序）
+   * @return {仍需进入 DFA 的规则, 关键字表}，规则编号均为 dfa_list 的下标
+   */
+  static std::pair<std::vector<int>, KeywordTable>
+  Extract(const std::vector<core::lexical::DfaModel> &dfa_list,
+          const std::vector<int> &rules);
+
+  /**
+   * 查询 [text, text + length) 对应的规则编号，不是关键字时返回 -1
+   * @param text
+   * @param length
+   * @return
+   */
+  int Find(const char *text, size_t length) const {
+    if (length < min_length_ || length > max_length_)
+      return -1;
+    size_t slot = Hash(text, length) & mask_;
+    const auto &keyword = slots_[slot];
+    if (rules_[slot] < 0 || keyword.size() != length ||
+        keyword.compare(0, length, text, length) != 0)
+      return -1;
+    return rules_[slot];
+  }
+
+  /**
+   * 匹配到规则 rule 后重新分类：词文是优先级更高的关键字时返回关键字的规则
+   * @param text
+   * @param length
+   * @param rule
+   * @return
+   */
+  int Reclassify(const char *text, size_t length, int rule) const {
+    int keyword = Find(text, length);
+    return keyword >= 0 && keyword < rule ? keyword : rule;
+  }
+
+  bool Empty() const { return size_ == 0; }
+
+  size_t Size() const { return size_; }
+
+  /**
+   * 全部关键字，按规则编号升序
+   * @return {关键字, 规则编号}
+   */
+  std::vector<std::pair<std::string, int>> GetKeywords() const;
+
+ private:
+  uint32_t Hash(const char *text, size_t length) const {
+    if (full_hash_) {
+      // FNV-1a
+      uint32_t h = 2166136261u ^ seed_;
+      for (size_t i = 0; i < length; ++i) {
+        h = (h ^ static_cast<unsigned char>(text[i])) * 16777619u;
+      }
+      return h ^ (h >> 15);
+    }
+    // 只取长度与首、中、尾三个字符，乘以种子后取高位
+    uint32_t key = static_cast<uint32_t>(length) ^
+                   static_cast<unsigned char>(text[0]) << 8 ^
+                   static_cast<unsigned char>(text[length / 2]) << 16 ^
+                   static_cast<unsigned char>(text[length - 1]) << 24;
+    return (key * seed_) >> 16;
+  }
+
+  // 槽位数为 2 的幂，空槽的规则编号为 -1
+  std::vector<std::string> slots_;
+
+  std::vector<int> rules_;
+
+  uint32_t seed_ = 0;
+
+  // 关键字的长度与首、中、尾字符不足以区分时，对整个字符串求散列
+  bool full_hash_ = false;
+
+  size_t mask_ = 0;
+
+  size_t size_ = 0;
+
+  // 空表时任何长度都不匹配
+  size_t min_length_ = 1;
+
+  size_t max_length_ = 0;
+};
+
+}
+
+#endif //SEULEXYACC_KEYWORDTABLE_H
@@ -0,0 +1,64 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#ifndef SEULEXYACC_LINEINDEX_H
+#define SEULEXYACC_LINEINDEX_H
+#include <cstddef>
+#include <vector>
+#include "AttrDict.h"
+
+
+namespace sly::runtime {
+
+/**
+ * 行首索引：成块地记录输入中换行符与制表符的位置，
+ * 只在需要时才把字节偏移换算成行列号（行列号从 1 开始，制表符对齐到 8 列）。
+ */
+class LineIndex {
+ public:
+  LineIndex();
+
+  /**
+   * 追加 [Indexed(), Indexed() + size) 的内容
+   * @param data 指向偏移 Indexed() 处的字节
+   * @param size
+   */
+  void Extend(const char *data, size_t size);
+
+  /**
+   * 丢弃偏移不小于 offset 的索引（输入在 offset 之后被修改）
+   * @param offset
+   */
+  void Truncate(size_t offset);
+
+  /**
+   * 已建立索引的字节数
+   * @return
+   */
+  size_t Indexed() const;
+
+  /**
+   * 换算行列号，要求 offset <= Indexed()
+   * @param offset
+   * @return
+   */
+  core::type::SourceLocation Locate(size_t offset) const;
+
+  void Clear();
+
+ private:
+  // line_starts_[i] 为第 i + 1 行的起始偏移
+  std::vector<size_t> line_starts_;
+
+  std::vector<size_t> tabs_;
+
+  size_t indexed_ = 0;
+
+  // 上一次查询所在的行（从 0 开始）
+  mutable size_t last_line_ = 0;
+};
+
+}
+
+#endif //SEULEXYACC_LINEINDEX_H
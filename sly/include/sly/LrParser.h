@@ -3,6 +3,8 @@
 
 #include "def.h"
 #include "ContextFreeGrammar.h"
+#include "DenseParsingTable.h"
+#include "CompressedParsingTable.h"
 #include "AnnotatedParseTree.h"
 
 #include <optional>
@@ -13,6 +15,16 @@ using namespace std;
 
 namespace sly::core::grammar {
 
+/**
+ * LrParser 分析时使用的表
+ */
+enum class ParsingTableKind {
+  // 稠密表（默认）
+  kDense,
+  // 压缩表：只有默认规约的状态不查看向前看符号
+  kCompressed
+};
+
 class LrParser {
  public:
   explicit LrParser(ParsingTable& parsing_table);
@@ -24,6 +36,12 @@ class LrParser {
   const ParsingTable &GetPt() const;
   
   void SetPt(const ParsingTable &pt);
+
+  /**
+   * 选择分析时使用的表，两种表的分析结果相同
+   * @param kind
+   */
+  void SetTableKind(ParsingTableKind kind);
   
   AnnotatedParseTree GetTree() const;
  
@@ -31,8 +49,25 @@ class LrParser {
   vector<Token> stream;
   
   void ParseOnce(const vector<Token>& token_stream, const vector<YYSTATE>& yylval_stream);
+
+  DenseParsingTable::Cell LookupAction(IdType state, int symbol) const;
+
+  int LookupGoto(IdType state, int symbol) const;
   
   ParsingTable pt_;
+
+  // 分析时使用的稠密表，由 pt_ 生成
+  DenseParsingTable dense_;
+
+  // 选择压缩表时由 dense_ 生成
+  CompressedParsingTable compressed_;
+
+  ParsingTableKind table_kind_ = ParsingTableKind::kDense;
+
+  // 当前 token 的编号，只在 current_offset_ 变化时重新查询
+  int current_symbol_ = -1;
+
+  IdType symbol_offset_ = static_cast<IdType>(-1);
   
   std::deque<AnnotatedParseTree> apt_stack_;
   
@@ -24,6 +24,13 @@ class Production {
   
   using TokenSet = std::unordered_set<Token, Token::Hash>;
   
+  /**
+   * 按 token 序列散列，用于按 token 序列查找产生式
+   */
+  struct TokenVecHash {
+    std::size_t operator()(const TokenVec &k) const;
+  };
+  
   bool CheckHealth() const;
   
   bool IsEpsilon() const;
@@ -7,36 +7,435 @@
 #include "def.h"
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <istream>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "AttrDict.h"
+#include "InputBuffer.h"
+#include "KeywordTable.h"
+#include "LineIndex.h"
 #include "Token.h"
 
 
 namespace sly::runtime {
 
-constexpr size_t LEX_BUFFER_SIZE = 4096;
+// 并行扫描时每块的最小字节数
+constexpr size_t PARALLEL_LEX_MIN_CHUNK = 64 * 1024;
+
+// 交错扫描时同时推进的输入个数
+constexpr size_t INTERLEAVED_LEX_STREAMS = 4;
+
+// 双字节步长表的最大项数，超过时该条件仍按单字节扫描
+constexpr size_t STRIDE_TABLE_MAX_ENTRIES = 1 << 17;
+
+/**
+ * Lex() 使用的扫描循环
+ */
+enum class ScanLoop {
+  // 每次读入一个字节（默认）
+  kByte,
+  // 每次处理 4 个字节，每块只判断一次是否经过接受状态
+  kUnrolled,
+  // 按字节等价类查双字节步长表，每次转移读入两个字节；表太大的条件退化为 kUnrolled
+  kStride2,
+};
+
+/**
+ * 词法单元：rule 为匹配到的规则编号（-1 表示输入结束），
+ * 词文为输入缓冲区中的 [offset, offset + length)，不做拷贝。
+ */
+struct Lexeme {
+  int rule;
+  size_t offset;
+  size_t length;
+};
+
+/**
+ * 增量扫描的结果：旧数组中 [first, first + removed) 被 inserted 替换，
+ * 其后的词法单元偏移量加上 shift
+ */
+struct LexemeDiff {
+  size_t first;
+  size_t removed;
+  std::vector<Lexeme> inserted;
+  ptrdiff_t shift;
+};
+
+/**
+ * 批量扫描的结果，由调用者提供的若干等长数组（结构体数组的转置）
+ */
+struct TokenBatch {
+  // 规则编号，对应构造时的 corr_token
+  int *rules;
+  size_t *offsets;
+  uint32_t *lengths;
+  // 为 nullptr 时不计算行列号
+  core::type::SourceLocation *locations;
+  size_t capacity;
+};
+
+/**
+ * yytext：指向输入缓冲区的词文视图，不拷贝词文。
+ * 越过末尾的下标返回 '\0'，兼容按 C 字符串遍历 yytext 的动作代码。
+ */
+class TextView : public std::string_view {
+ public:
+  using std::string_view::string_view;
+
+  TextView(std::string_view view) : std::string_view(view) {}
+
+  char operator[](size_t i) const { return i < size() ? data()[i] : '\0'; }
+
+  operator std::string() const { return std::string(data(), size()); }
+};
+
+/**
+ * 以只读方式映射到内存的输入文件，View() 之后紧跟一个 '\0' 哨兵
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &path);
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile();
+
+  std::string_view View() const;
+
+ private:
+  const char *data_ = nullptr;
+
+  size_t size_ = 0;
+
+  // 包含哨兵页在内的映射长度
+  size_t mapped_size_ = 0;
+
+  // 无法 mmap 时（如空文件）退化为读入内存
+  std::string fallback_;
+};
 
 // Run and return id.
-class SeuLex {
+class SeuLex : public core::type::SourceLocator {
  public:
   using Token = core::type::Token;
 
+  SeuLex() = default;
+
+  explicit SeuLex(const std::vector<std::vector<int>> &working_table,
+                  std::vector<int> accept_states, std::vector<Token> corr_token,
+                  Token end_token);
+
+  /**
+   * 只指定规则对应的词法单元，各起始条件的表由 AddCondition() 依次添加
+   * @param corr_token
+   * @param end_token
+   */
+  explicit SeuLex(std::vector<Token> corr_token, Token end_token);
+
+  /**
+   * 添加一个起始条件（start condition），使用自己的状态转移表，
+   * 表中只包含该条件下活跃的规则。构造时的表为条件 0（INITIAL）
+   * @param working_table
+   * @param accept_states 接受状态对应的规则编号，对应构造时的 corr_token，
+   * 编号越界时抛出 runtime_error
+   * @param keywords 没有进入 working_table 的关键字规则，匹配后据此重新分类
+   * @return 条件编号
+   */
+  int AddCondition(const std::vector<std::vector<int>> &working_table,
+                   std::vector<int> accept_states, KeywordTable keywords = {});
+
+  /**
+   * BEGIN(condition)：之后的扫描使用该条件的状态转移表
+   * @param condition
+   */
+  void Begin(int condition);
+
+  /**
+   * YY_START：当前的起始条件
+   * @return
+   */
+  int GetCondition() const;
+
+  /**
+   * 选择 Lex() / LexBatch() / Process() 的扫描循环，各循环的结果相同
+   * @param loop
+   */
+  void SetScanLoop(ScanLoop loop);
+
+  /**
+   * 剖析模式：Lex() / LexBatch() / Process() 统计每个状态的行被读取的次数，
+   * 开启时清空之前的计数
+   * @param enable
+   */
+  void SetProfiling(bool enable);
+
+  /**
+   * 各状态被访问的次数，下标为状态编号
+   * @param condition
+   * @return
+   */
+  const std::vector<uint64_t> &GetStateVisits(int condition) const;
+
+  /**
+   * 按剖析得到的访问次数重新编号所有条件的状态，使访问最多的行在内存中相邻；
+   * 入口状态保持为 DFA_ENTRY_STATE_ID，识别结果不变
+   */
+  void RenumberStates();
+
+  /**
+   * 保存各起始条件的状态转移表（含当前的状态编号）与关键字表
+   * @param os
+   */
+  void SaveTables(std::ostream &os) const;
+
+  /**
+   * 读入 SaveTables() 保存的表，替换现有的全部条件，词法单元仍为构造时的 corr_token
+   * @param is
+   */
+  void LoadTables(std::istream &is);
+
+  /**
+   * 映射文件作为输入
+   * @param path
+   */
+  void Open(const std::string &path);
+
+  /**
+   * 使用调用者持有的连续缓冲区作为输入，扫描期间缓冲区必须保持有效，
+   * 且 input.data()[input.size()] 可读（如 std::string），用作哨兵
+   * @param input
+   */
+  void SetInput(std::string_view input);
+
+  /**
+   * 以流式方式从 yyin 读入（管道、标准输入等），缓冲区容量固定。
+   * 此时 Text() 只对最近一次 Lex() 的结果有效。
+   * @param in
+   * @param capacity
+   */
+  void SetIn(std::istream *in, size_t capacity = LEX_BUFFER_SIZE);
+
+  /**
+   * 识别下一个词法单元
+   * @return
+   */
+  Lexeme Lex();
+
+  /**
+   * 连续识别至多 batch.capacity 个词法单元，写入 batch 的各个数组
+   * @param batch
+   * @return 写入的个数，小于 capacity 表示输入已经结束
+   */
+  size_t LexBatch(const TokenBatch &batch);
+
+  /**
+   * 扫描全部输入，结果见 GetLexemes()。
+   * 不执行动作，因此整个输入都在当前的起始条件下扫描，下同
+   */
   void Process();
 
+  /**
+   * 多线程扫描全部输入，结果与 Process() 相同。
+   * 输入被分成若干块，各块从推测的起点（换行之后）同时扫描，
+   * 再顺序拼接：顺序扫描到达某块的词法单元起点后直接采用该块的结果。
+   * 流式输入时退化为 Process()。
+   * @param thread_count
+   */
+  void ParallelProcess(size_t thread_count);
+
+  /**
+   * 编辑后增量扫描：把 [offset, offset + deleted) 替换为 text，
+   * 从编辑位置之前最近的、可能受影响的词法单元开始重新扫描，
+   * 直到与旧的词法单元起点重新对齐。GetLexemes() 随之更新。
+   * 需要先对整个输入调用过 Process() / ParallelProcess()，不支持流式输入。
+   * 第一次编辑时会复制一份输入，之后 Text() 指向这份副本。
+   * @param offset
+   * @param deleted
+   * @param text
+   * @return 相对编辑前 GetLexemes() 的差异
+   */
+  LexemeDiff Relex(size_t offset, size_t deleted, std::string_view text);
+
+  /**
+   * 交错扫描多个互相独立的输入（如大量小文件）：同时推进 INTERLEAVED_LEX_STREAMS 个自动机，
+   * 轮流各走一步，使它们的查表互相重叠；某个输入结束后换上下一个。
+   * 使用当前的起始条件，不影响 SetInput() 等设置的输入。
+   * @param inputs 每个输入都要满足 SetInput() 的要求：input.data()[input.size()] 可读
+   * @return 每个输入的词法单元，偏移量相对于各自的输入
+   */
+  std::vector<std::vector<Lexeme>> LexStreams(const std::vector<std::string_view> &inputs) const;
+
+  TextView Text(const Lexeme &lexeme) const;
+
+  const Token &GetToken(const Lexeme &lexeme) const;
+
+  const std::vector<Lexeme> &GetLexemes() const;
+
+  /**
+   * 返回 offset 处的行列号（从 1 开始）。扫描时只记录字节偏移，
+   * 行首索引在第一次查询时成块建立，之后每次查询为一次二分查找
+   * @param offset
+   * @return
+   */
+  core::type::SourceLocation Locate(size_t offset) override;
+
+  /**
+   * 供用户动作使用的 input()：读取一个字符，输入结束时返回 0
+   * @return
+   */
+  char Input();
+
+  /**
+   * 供用户动作使用的 unput()：把字符 c 退回输入，之后先读到 c。
+   * 与 flex 相同，c 写在刚读过的字符的位置上（会改变该位置的词文），因此退回的字符数
+   * 不能超过当前缓冲区中已读过的字符数；对映射文件或 SetInput 给出的输入第一次写入时
+   * 会复制一份输入，原输入保留到下一次 Open / SetInput / SetIn，此前 Text() 返回的
+   * 视图不受影响。退回的正是刚读过的字符时不做任何写入
+   * @param c
+   */
+  void Unput(char c);
+
+  void SetOut(std::ostream *out);
+
+  /**
+   * ECHO：将词文输出到 yyout
+   * @param lexeme
+   */
+  void Echo(const Lexeme &lexeme) const;
+
  private:
-  std::vector<std::array<int, 128>> table_;
-  
+  /**
+   * 识别一个词法单元，返回规则编号（-1 表示输入结束），词法错误时抛出异常
+   * @param offset
+   * @param length
+   * @return
+   */
+  int Scan(size_t &offset, size_t &length);
+
+  /**
+   * 从 start 开始做一次最长匹配，不补充输入、不修改扫描器状态，可在多个线程中同时调用
+   * @param start
+   * @param length 匹配长度
+   * @param stop 自动机停止的位置
+   * @return 规则编号，-1 表示匹配失败
+   */
+  int MatchAt(const char *start, size_t &length, const char *&stop) const;
+
+  /**
+   * 从 first 开始连续匹配起点在 [first, last) 内的词法单元，遇到匹配失败时停止
+   */
+  void ScanChunk(const char *first, const char *last,
+                 std::vector<Lexeme> &result, size_t &max_span) const;
+
+  [[noreturn]] void ReportError(const char *start, const char *p);
+
+  /**
+   * 保证 [0, offset) 已建立行首索引
+   * @param offset
+   */
+  void IndexUpTo(size_t offset);
+
+  /**
+   * 读到哨兵时补充输入，token_start 与 p 会随缓冲区移动
+   * @return 是否读入了新数据
+   */
+  bool Refill(const char *&token_start, const char *&p);
+
+  // 连续两次转移的结果
+  struct StrideEntry {
+    // 两个字节之后的状态在 stride 中的行首（next * class_count^2），
+    // 使查下一项时不必再做乘法
+    int next_row;
+    // 两个字节之后的状态，任一字节无法转移时为 -1
+    int next;
+    // 第一个字节之后的状态接受的规则，-1 表示不接受
+    int middle_rule;
+  };
+
+  struct ScanTable {
+    // 每行 256 列，>= 128 的字节恒为 -1，扫描时无需判断范围
+    std::vector<std::array<int, 256>> transition;
+
+    std::vector<int> accept_states;
+
+    KeywordTable keywords;
+
+    // 字节等价类：所有状态下转移都相同的字节属于同一类
+    std::array<uint8_t, 256> classes;
+
+    size_t class_count = 0;
+
+    // stride[(state * class_count + 第一个字节的类) * class_count + 第二个字节的类]，
+    // 为空表示没有建立
+    std::vector<StrideEntry> stride;
+
+    // 剖析模式下各状态被访问的次数
+    std::vector<uint64_t> visits;
+  };
+
+  /**
+   * 为 table 建立字节等价类与双字节步长表，表项数超过 STRIDE_TABLE_MAX_ENTRIES 时不建立
+   * @param table
+   */
+  static void BuildStride(ScanTable &table);
+
+  /**
+   * 按 visits 降序重新编号 table 的状态，入口状态不动
+   * @param table
+   */
+  static void Renumber(ScanTable &table);
+
+  // 每个起始条件一张表，下标为条件编号
+  std::vector<ScanTable> conditions_;
+
+  int condition_ = 0;
+
+  ScanLoop scan_loop_ = ScanLoop::kByte;
+
+  bool profiling_ = false;
+
   std::vector<Token> tokens_;
-  
+
+  Token end_token_;
+
+  std::vector<Lexeme> lexemes_;
+
   YYSTATE yylval;
 
-  std::istream* yyin;
+  std::istream* yyin = nullptr;
+
+  std::ostream* yyout = nullptr;
+
+  std::unique_ptr<MappedFile> file_;
+
+  std::unique_ptr<InputBuffer> stream_;
+
+  const char *begin_ = nullptr;
+
+  const char *cursor_ = nullptr;
+
+  // 最近一个词法单元的起点，流式输入补充数据时从这里开始保留
+  const char *token_ = nullptr;
+
+  const char *end_ = nullptr;
+
+  // begin_ 在整个输入中的偏移
+  size_t base_ = 0;
+
+  // 识别词法单元时自动机走过的最大长度（含最后读入的字符）
+  size_t max_span_ = 0;
 
-  std::ostream* yyout;
+  // Relex 与 Unput 修改的输入副本
+  std::string edit_buffer_;
 
+  // 行首索引，在第一次查询行列号或补充流式输入时成块建立
+  LineIndex lines_;
 };
 
 // yyin 和yyout ：这是Lex中本身已定义的输入和输出文件指针。这两个变量指明了lex生成的词法分析器从哪里获得输入和输出到哪里。默认：键盘输入，屏幕输出。
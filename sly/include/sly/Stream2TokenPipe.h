@@ -10,6 +10,7 @@
 #include "AttrDict.h"
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace sly::runtime {
@@ -35,9 +36,33 @@ class Stream2TokenPipe {
   int token_end_col_;
 
   char input(std::istream& is);
-  void unput(std::istream& is, char c); 
+  void unput(char c);
 
  private:
+  /**
+   * 读取 window_[i]，必要时从 is 读入；输入结束时返回 false
+   * @param is
+   * @param i
+   * @param c
+   * @return
+   */
+  bool Peek(std::istream& is, size_t i, char &c);
+
+  /**
+   * 按字符 c 更新行列号
+   * @param c
+   */
+  void Advance(char c);
+
+  /**
+   * 按已消耗的词文成块更新行列号
+   * @param text
+   */
+  void Advance(std::string_view text);
+
+  // 已从流中读出的字符，[pos_, size) 为尚未消耗的部分，回退只需移动 pos_
+  std::string window_;
+  size_t pos_ = 0;
 
   std::string history_;
   int history_count_;
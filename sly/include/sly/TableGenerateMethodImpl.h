@@ -7,59 +7,244 @@
 #include "def.h"
 #include "TableGenerateMethod.h"
 #include "ContextFreeGrammar.h"
+#include "GrammarIndex.h"
+#include <functional>
+#include <map>
+#include <optional>
 
 namespace sly::core::grammar {
 
-class Lr1: public TableGenerateMethod{
-  using TokenSet = unordered_set<Token, Token::Hash>;
+/**
+ * 由 LR 项集族与 GO 表填写分析表并处理冲突，Lr1 与 Lalr 共用
+ */
+class LrTableGenerateMethod: public TableGenerateMethod {
+ public:
+  /**
+   * 填表时遇到的冲突（无论是否已经按结合律或优先级解决）
+   */
+  struct Conflict {
+    IdType state;
+    Token token;
+    // true 为 shift-in <> reduce，false 为 reduce <> reduce
+    bool shift_reduce;
+    // 参与冲突的产生式
+    vector<IdType> productions;
+  };
+
+  const vector<Conflict> &GetConflicts() const;
+
+  size_t GetStateCount() const;
+
+  /**
+   * 构造项集族与填表时使用的线程数，默认为 1。
+   * 结果与线程数无关：状态编号、分析表与冲突的顺序都和单线程相同。
+   * @param thread_count
+   */
+  void SetThreadCount(size_t thread_count);
+
+ protected:
+  void GenTable();
+
+  /**
+   * 填写状态 i 的 ACTION 与 GOTO 行，不同状态可以并行调用
+   */
+  void GenTableRow(IdType i, const vector<Token> &aug_terminators,
+                   vector<Conflict> &conflicts);
+
+  /**
+   * 用 thread_count_ 个线程对 [0, n) 中每个下标调用 f，f 抛出的第一个异常在调用线程重新抛出
+   */
+  void ParallelFor(size_t n, const function<void(size_t)> &f) const;
+
+  size_t thread_count_ = 1;
+
+  /**
+   * 返回项目所属的产生式编号，项目未带编号时按 token 序列查找
+   */
+  IdType ProductionOf(const LRItem &item) const;
 
+  vector<unordered_map<Token, IdType, Token::Hash>> item_go_map_;
+
+  vector<LRItemSet> lr_item_set_;
+
+  vector<Conflict> conflicts_;
+};
+
+/**
+ * 规范 LR(1)：项目为 (产生式编号, 圆点位置) 整数对，向前看符号为终结符位串。
+ * 只对圆点后实际出现的符号求 GO，目标状态按核心项目（连同向前看符号）散列查找。
+ */
+class Lr1: public LrTableGenerateMethod{
  public:
   void Defer(const ContextFreeGrammar &cfg) override;
  
- private:
+ protected:
+  using Item = GrammarIndex::Item;
+  
+  struct State {
+    // 核心项目，按项目升序
+    vector<Item> kernel;
+    // 与 kernel 一一对应的向前看符号
+    vector<TerminalSet> look_ahead;
+    // {符号, 目标状态}，按符号升序
+    vector<pair<int, int>> go;
+  };
   
   /**
-   * 计算 First 集
+   * 状态经 symbol 转移后的核心项目
    */
-  void GenFirst();
-  
-  vector<IdType> DeferGotoCause(IdType lhs, IdType rhs, const Token &tok);
+  struct Successor {
+    int symbol;
+    vector<Item> kernel;
+    vector<TerminalSet> look_ahead;
+    size_t hash;
+  };
   
+  /**
+   * 计算 LR-项集族。逐层展开：同一层（pending_ 中）的状态并行求闭包与后继，
+   * 再按状态、符号的顺序依次查找或新建目标状态，所以编号与线程数无关。
+   * 状态的向前看符号因合并而增加时放入下一层重新展开。
+   */
+  void GenStates();
   
   /**
-   * 计算 Follow 集
+   * 求状态 i 的闭包并按圆点后的符号分组，只读 states_，可以并行调用
    */
-  void GenFollow();
+  vector<Successor> GetSuccessors(int i) const;
   
   /**
-   * 计算 token list 的 first 集合
-   * @param first
-   * @param last
+   * 找到核心为 (kernel, look_ahead) 的状态，不存在时新建，返回状态编号
+   * @param kernel 按项目升序
+   * @param look_ahead
+   * @param hash 核心的散列值
    * @return
    */
-  TokenSet GetFirst(vector<Token>::const_iterator first, vector<Token>::const_iterator last) const;
-  
+  virtual int FindOrMerge(vector<Item> kernel, vector<TerminalSet> look_ahead,
+                          size_t hash);
   
   /**
-   * 计算 LR-项集 和 GO 表
-   * @param method
+   * 新建状态并加入 pending_
    */
-  void GenItemGo();
+  int AddState(vector<Item> kernel, vector<TerminalSet> look_ahead);
   
-  void GenTable();
+  void Enqueue(int state);
   
-  unordered_set<LRItem, LRItem::Hash> Lr1Closure(LRItemSet lrs) const;
+  /**
+   * 从 0 号状态按符号顺序重新编号可达状态，生成 LRItemSet 与 GO 表。
+   * GenTable 只用到可规约项目与圆点后为终结符的项目，其余项目不生成，
+   * 向前看符号也只保留在可规约项目上。
+   */
+  void GenItemGo();
   
-  optional<unordered_set<LRItem, LRItem::Hash>> Lr1GotoFunc(const LRItemSet &lrs, const Token &tok) const;
+  optional<GrammarIndex> grammar_;
   
-  vector<unordered_map<Token, IdType, Token::Hash>> item_go_map_;
+  vector<State> states_;
   
-  vector<LRItemSet> lr_item_set_;
+ private:
+  static size_t HashOf(const vector<Item> &kernel,
+                       const vector<TerminalSet> &look_ahead);
   
-  unordered_map<Token, TokenSet, Token::Hash> first_set_;
+  // 核心的散列值 -> 状态编号
+  unordered_map<size_t, vector<int>> kernel_id_;
   
-  unordered_map<Token, TokenSet, Token::Hash> follow_set_;
+  // 下一层待（重新）展开的状态
+  vector<int> pending_;
   
+  vector<bool> is_pending_;
+};
+
+/**
+ * LALR(1)：先构造 LR(0) 项集族，再在其上用 DeRemer–Pennello 方法
+ * （DR / reads / includes / lookback 四个关系上的 digraph 传播）计算向前看符号，
+ * 不经过 LR(1) 项集族的构造与合并。
+ *
+ * 合并同心项集只可能引入 reduce <> reduce 冲突，这类冲突会额外报告出来。
+ */
+class Lalr: public LrTableGenerateMethod {
+ public:
+  void Defer(const ContextFreeGrammar &cfg) override;
+
+ private:
+  using Item = GrammarIndex::Item;
+
+  /**
+   * 计算 LR(0) 项集族与 GO 表
+   */
+  void GenLr0();
+
+  /**
+   * 计算每个可规约项目的 LALR(1) 向前看符号
+   */
+  void GenLookAhead();
+
+  /**
+   * 将 LR(0) 项集与向前看符号转换为 LRItemSet，供 GenTable 使用
+   */
+  void GenItemGo();
+
+  /**
+   * 报告可能由合并同心项集引入的冲突
+   */
+  void ReportConflicts() const;
+
+  vector<Item> Lr0Closure(const vector<Item> &kernel) const;
+
+  int GoOf(IdType state, int symbol) const;
+
+  optional<GrammarIndex> grammar_;
+
+  // LR(0) 项集（只保存核心项目）
+  vector<vector<Item>> kernels_;
+
+  // go_[state] 为 {符号, 目标状态}，按符号升序
+  vector<vector<pair<int, int>>> go_;
+
+  // look_ahead_[state][prod] 为状态中可规约项目的向前看符号
+  vector<unordered_map<IdType, TerminalSet>> look_ahead_;
+};
+
+/**
+ * 最小 LR(1)：按 Pager 的弱相容（weak compatibility）条件合并同心的 LR(1) 项集。
+ *
+ * 新项集与已有的同心项集核心项目的向前看符号分别为 M 与 L，若对任意 i != j，
+ * (Li ∩ Mj) ∪ (Lj ∩ Mi) 为空，或 Li ∩ Lj、Mi ∩ Mj 非空，则合并不会引入
+ * 规范 LR(1) 中没有的 reduce <> reduce 冲突，两者合并；否则另建状态。
+ * 因此分析能力与 Lr1 相同，状态数与 Lalr 接近（文法是 LALR(1) 时相同）。
+ *
+ * 弱相容只保证无冲突的文法与 Lr1 等价。冲突按结合律或优先级解决后，合并会把某个
+ * 状态上的解决结果带到 Lr1 中本无冲突的状态（例如悬挂 else 选择规约时，
+ * 不在 if 内的 if 也不能再接 else）。因此第一遍有冲突时，把冲突涉及的终结符记为
+ * split_tokens_ 重新构造一遍，只合并在这些终结符上向前看符号完全相同的状态，
+ * 与 IELR(1) 的目的相同：冲突的解决结果与 Lr1 一致。
+ */
+class MinimalLr1: public Lr1 {
+ public:
+  void Defer(const ContextFreeGrammar &cfg) override;
+
+ protected:
+  /**
+   * 找到可以接纳 (kernel, look_ahead) 的状态，必要时合并或新建，返回状态编号
+   */
+  int FindOrMerge(vector<Item> kernel, vector<TerminalSet> look_ahead,
+                  size_t hash) override;
+
+ private:
+  static bool IsWeaklyCompatible(const vector<TerminalSet> &l,
+                                 const vector<TerminalSet> &m);
+
+  /**
+   * 两组向前看符号在 split_tokens_ 上是否相同
+   */
+  bool AgreesOnSplitTokens(const vector<TerminalSet> &l,
+                           const vector<TerminalSet> &m) const;
+
+  // 同心项集：核心 -> 状态编号
+  map<vector<Item>, vector<int>> core_states_;
+
+  size_t merge_count_ = 0;
+
+  // 冲突涉及的终结符，在这些终结符上向前看符号不同的状态不合并
+  TerminalSet split_tokens_;
 };
 
 }
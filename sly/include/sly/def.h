@@ -87,6 +87,8 @@ class Lr1;
 
 class Lalr;
 
+class MinimalLr1;
+
 /**
  * 给定 `ParsingTable` 和 stream<Token> 进行识别
  */
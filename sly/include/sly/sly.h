@@ -11,10 +11,17 @@
 #include <sly/Production.h>
 #include <sly/ContextFreeGrammar.h>
 #include <sly/TableGenerateMethod.h>
+#include <sly/GrammarIndex.h>
 #include <sly/TableGenerateMethodImpl.h>
+#include <sly/DenseParsingTable.h>
+#include <sly/CompressedParsingTable.h>
 #include <sly/FaModel.h>
+#include <sly/InputBuffer.h>
+#include <sly/KeywordTable.h>
+#include <sly/LineIndex.h>
 #include <sly/LrParser.h>
 #include <sly/RegEx.h>
+#include <sly/SeuLex.h>
 #include <sly/Stream2TokenPipe.h>
 
 #endif //SEULEXYACC_SLY_H
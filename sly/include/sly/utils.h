@@ -307,6 +307,41 @@ public:
 #define FUNC_START_INFO
 #endif
 
+// 编译期日志级别，取值与 spdlog::level 相同。低于 SLY_ACTIVE_LOG_LEVEL 的
+// SLY_LOG_* 调用在编译期被整体去除（包括参数的求值），用于扫描、分析等热点路径。
+#define SLY_LOG_LEVEL_TRACE 0
+#define SLY_LOG_LEVEL_DEBUG 1
+#define SLY_LOG_LEVEL_INFO 2
+#define SLY_LOG_LEVEL_WARN 3
+#define SLY_LOG_LEVEL_ERROR 4
+#define SLY_LOG_LEVEL_OFF 6
+
+#ifndef SLY_ACTIVE_LOG_LEVEL
+#ifndef NDEBUG
+#define SLY_ACTIVE_LOG_LEVEL SLY_LOG_LEVEL_DEBUG
+#else
+#define SLY_ACTIVE_LOG_LEVEL SLY_LOG_LEVEL_INFO
+#endif
+#endif
+
+#if SLY_ACTIVE_LOG_LEVEL <= SLY_LOG_LEVEL_TRACE
+#define SLY_LOG_TRACE(...) spdlog::trace(__VA_ARGS__)
+#else
+#define SLY_LOG_TRACE(...) (void)0
+#endif
+
+#if SLY_ACTIVE_LOG_LEVEL <= SLY_LOG_LEVEL_DEBUG
+#define SLY_LOG_DEBUG(...) spdlog::debug(__VA_ARGS__)
+#else
+#define SLY_LOG_DEBUG(...) (void)0
+#endif
+
+#if SLY_ACTIVE_LOG_LEVEL <= SLY_LOG_LEVEL_INFO
+#define SLY_LOG_INFO(...) spdlog::info(__VA_ARGS__)
+#else
+#define SLY_LOG_INFO(...) (void)0
+#endif
+
 
 template<typename T>
 std::string to_string(const T& v) {
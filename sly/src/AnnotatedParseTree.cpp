@@ -115,9 +115,16 @@ void AnnotatedParseTree::Print_(ostream &oss, bool forShort, bool printAttr, int
       oss << "]";
     }
   } else {
-    oss << "<line:" << attrs_[0].Get<int>("row") << ":" << attrs_[0].Get<int>("col") << ">";
-    oss << " ";
-    oss << "\"\033[33m" << sly::utils::escape(attrs_[0].Get<string>("lval")) << "\033[0m\"";
+    if (attrs_[0].HasLexeme()) {
+      const auto &loc = attrs_[0].GetLocation();
+      oss << "<line:" << loc.row << ":" << loc.col << ">";
+      oss << " ";
+      oss << "\"\033[33m" << sly::utils::escape(string(attrs_[0].GetLexeme())) << "\033[0m\"";
+    } else {
+      oss << "<line:" << attrs_[0].Get<int>("row") << ":" << attrs_[0].Get<int>("col") << ">";
+      oss << " ";
+      oss << "\"\033[33m" << sly::utils::escape(attrs_[0].Get<string>("lval")) << "\033[0m\"";
+    }
     if (printAttr) {
       oss << " [";
       if (!attrs_.empty()) {
@@ -28,6 +28,12 @@ map<string, string> AttrDict::ToStrDict() const {
       retval.emplace(k, tid.name());
     }
   }
+  // map 中的同名属性优先
+  if (has_lexeme_) {
+    retval.emplace("lval", string(lexeme_));
+    retval.emplace("row", std::to_string(GetLocation().row));
+    retval.emplace("col", std::to_string(GetLocation().col));
+  }
   return move(retval);
 }
 
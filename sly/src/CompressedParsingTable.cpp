@@ -0,0 +1,173 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#include <sly/CompressedParsingTable.h>
+#include <sly/utils.h>
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace sly::core::grammar {
+
+namespace {
+
+/**
+ * 返回出现次数最多的值，次数相同时取较小者；values 为空时返回 -1
+ */
+int MostFrequent(vector<int> values) {
+  sort(values.begin(), values.end());
+  int best = -1;
+  size_t best_count = 0;
+  for (size_t i = 0; i < values.size();) {
+    size_t j = i;
+    while (j < values.size() && values[j] == values[i])
+      ++j;
+    if (j - i > best_count) {
+      best = values[i];
+      best_count = j - i;
+    }
+    i = j;
+  }
+  return best;
+}
+
+} // namespace
+
+CompressedParsingTable::CompressedParsingTable(const DenseParsingTable &dense)
+    : n_terminators_(dense.GetTerminatorCount()) {
+  const size_t n_states = dense.GetStateCount();
+  const size_t n_symbols = dense.GetSymbolCount();
+  const size_t n_non_terminators = n_symbols - n_terminators_;
+  for (size_t s = 0; s < n_symbols; ++s)
+    symbol_id_.insert({dense.GetSymbols()[s], static_cast<int>(s)});
+  for (IdType p = 0; p < dense.GetProductionCount(); ++p) {
+    lhs_.push_back(dense.GetLhs(p));
+    rhs_length_.push_back(dense.GetRhsLength(p));
+  }
+
+  // 每一行/列去掉默认值后剩下的格子，前 n_states 个为 ACTION 行，之后为 GOTO 列
+  vector<vector<pair<int, uint32_t>>> vectors(n_states + n_non_terminators);
+
+  // 1. ACTION：出现最多的规约作为默认动作，错误格子也归入默认动作
+  default_action_.resize(n_states);
+  default_reduction_.resize(n_states);
+  for (IdType i = 0; i < n_states; ++i) {
+    vector<int> reductions;
+    for (size_t s = 0; s < n_terminators_; ++s) {
+      auto cell = dense.GetAction(i, static_cast<int>(s));
+      if (cell.action == ParsingTable::kReduce)
+        reductions.push_back(static_cast<int>(cell.id));
+    }
+    int reduction = MostFrequent(reductions);
+    default_reduction_[i] = reduction;
+    default_action_[i] =
+        reduction < 0 ? DenseParsingTable::Encode(ParsingTable::kError, 0)
+                      : DenseParsingTable::Encode(ParsingTable::kReduce,
+                                                  reduction);
+    for (size_t s = 0; s < n_terminators_; ++s) {
+      auto cell = dense.GetAction(i, static_cast<int>(s));
+      auto code = DenseParsingTable::Encode(cell.action, cell.id);
+      if (cell.action == ParsingTable::kError || code == default_action_[i])
+        continue;
+      vectors[i].emplace_back(static_cast<int>(s), code);
+    }
+  }
+
+  // 2. GOTO：出现最多的目标状态作为默认值
+  default_goto_.resize(n_non_terminators);
+  for (size_t nt = 0; nt < n_non_terminators; ++nt) {
+    int symbol = static_cast<int>(n_terminators_ + nt);
+    vector<int> targets;
+    for (IdType i = 0; i < n_states; ++i) {
+      int go = dense.GetGoto(i, symbol);
+      if (go >= 0)
+        targets.push_back(go);
+    }
+    default_goto_[nt] = MostFrequent(targets);
+    for (IdType i = 0; i < n_states; ++i) {
+      int go = dense.GetGoto(i, symbol);
+      if (go >= 0 && go != default_goto_[nt])
+        vectors[n_states + nt].emplace_back(static_cast<int>(i),
+                                            static_cast<uint32_t>(go));
+    }
+  }
+
+  // 3. 叠放：先放跨度大、格子多的，内容相同的行/列共用位移
+  vector<size_t> order(vectors.size());
+  iota(order.begin(), order.end(), 0);
+  auto width = [&vectors](size_t v) {
+    return vectors[v].empty()
+               ? 0
+               : vectors[v].back().first - vectors[v].front().first + 1;
+  };
+  stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (width(a) != width(b))
+      return width(a) > width(b);
+    return vectors[a].size() > vectors[b].size();
+  });
+
+  vector<int> base(vectors.size(), kNoBase);
+  map<pair<bool, vector<pair<int, uint32_t>>>, int> placed;
+  unordered_set<int> used_base;
+  size_t low_free = 0;
+  for (auto v : order) {
+    if (vectors[v].empty())
+      continue;
+    auto key = make_pair(v < n_states, vectors[v]);
+    auto f = placed.find(key);
+    if (f != placed.end()) {
+      base[v] = f->second;
+      ++shared_vector_count_;
+      continue;
+    }
+    base[v] = Pack(vectors[v], used_base, low_free);
+    placed.insert({std::move(key), base[v]});
+  }
+  action_base_.assign(base.begin(), base.begin() + n_states);
+  goto_base_.assign(base.begin() + n_states, base.end());
+
+  SLY_LOG_DEBUG("Compressed parsing table: {} states, {} symbols, packed {} "
+                "cells, {} shared vectors",
+                n_states, n_symbols, table_.size(), shared_vector_count_);
+}
+
+int CompressedParsingTable::Pack(const vector<pair<int, uint32_t>> &entries,
+                                 unordered_set<int> &used_base,
+                                 size_t &low_free) {
+  int base = static_cast<int>(low_free) - entries.front().first;
+  while (true) {
+    bool fit = used_base.find(base) == used_base.end();
+    for (size_t k = 0; fit && k < entries.size(); ++k) {
+      size_t loc = base + entries[k].first;
+      fit = loc >= check_.size() || check_[loc] == -1;
+    }
+    if (fit)
+      break;
+    ++base;
+  }
+  for (const auto &[index, value] : entries) {
+    size_t loc = base + index;
+    if (loc >= check_.size()) {
+      check_.resize(loc + 1, -1);
+      table_.resize(loc + 1, 0);
+    }
+    check_[loc] = index;
+    table_[loc] = value;
+  }
+  used_base.insert(base);
+  while (low_free < check_.size() && check_[low_free] != -1)
+    ++low_free;
+  return base;
+}
+
+size_t CompressedParsingTable::GetForcedReductionCount() const {
+  size_t count = 0;
+  for (IdType i = 0; i < action_base_.size(); ++i) {
+    if (GetForcedReduction(i) >= 0)
+      ++count;
+  }
+  return count;
+}
+
+} // namespace sly::core::grammar
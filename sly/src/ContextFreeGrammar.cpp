@@ -55,6 +55,7 @@ void ContextFreeGrammar::CheckHealthAndPrepare() {
   non_terminators_.clear();
   terminators_.clear();
   terminators_.emplace_back(ending_token_);
+  terminator_set_.insert(ending_token_);
   
   for (auto &prod: productions_) {
     // 所有产生式左部的都是非终结符。
@@ -94,7 +95,7 @@ void ContextFreeGrammar::CheckHealthAndPrepare() {
             throw runtime_error("Found Epsilon in token-list.");
           break;
         case Token::Type::kTerminator:
-          if (find(terminators_.begin(), terminators_.end(), tok) == terminators_.end())
+          if (terminator_set_.find(tok) == terminator_set_.end())
             throw runtime_error("Cannot find terminator. <" + tok.GetTokName() + ">");
           break;
         case Token::Type::kNonTerminator:
@@ -111,16 +112,18 @@ void ContextFreeGrammar::CheckHealthAndPrepare() {
     auto &prod = productions_[i];
     auto &lhs = prod.GetTokens().front();
     tok_prod_id_map_[lhs].push_back(i);
+    prod_id_map_.insert({prod.GetTokens(), i});
   }
   
-  // 5. 确保没有重复产生式
-  for (const auto &pi: productions_) {
-    int count = 0;
-    for (const auto &pj: productions_) {
-      if (pi == pj) count += 1;
+  // 5. 确保没有重复产生式：只需比较 token 序列相同的产生式
+  unordered_map<Production::TokenVec, vector<IdType>, Production::TokenVecHash> same_tokens;
+  for (IdType i = 0; i < productions_.size(); ++i) {
+    auto &ids = same_tokens[productions_[i].GetTokens()];
+    for (auto j: ids) {
+      if (productions_[i] == productions_[j])
+        throw runtime_error("Found duplicated production.");
     }
-    if (count > 1)
-      throw runtime_error("Found duplicated production.");
+    ids.push_back(i);
   }
   FUNC_END_INFO;
 }
@@ -135,6 +138,9 @@ void ContextFreeGrammar::Compile(TableGenerateMethod& method) {
 void ContextFreeGrammar::Reset() {
   non_terminators_.clear();
   terminators_.clear();
+  tok_prod_id_map_.clear();
+  terminator_set_.clear();
+  prod_id_map_.clear();
   lr_table_.Reset();
 }
 
@@ -149,8 +155,7 @@ bool ContextFreeGrammar::PutTerminator(const Token &tok) {
   if (tok.GetTokenType() != Token::Type::kTerminator &&
       tok.GetTokenType() != Token::Type::kEpsilon)
     return false;
-  auto it = find(terminators_.begin(), terminators_.end(), tok);
-  if (it == terminators_.end())
+  if (terminator_set_.insert(tok).second)
     terminators_.push_back(tok);
   return true;
 }
@@ -158,22 +163,17 @@ bool ContextFreeGrammar::PutTerminator(const Token &tok) {
 bool ContextFreeGrammar::PutNonTerminator(const Token &tok) {
   if (tok.GetTokenType() != Token::Type::kNonTerminator)
     return false;
-  auto it = find(non_terminators_.begin(), non_terminators_.end(), tok);
-  if (it == non_terminators_.end()) {
+  if (tok_prod_id_map_.insert({tok, {}}).second)
     non_terminators_.push_back(tok);
-    tok_prod_id_map_.insert({tok, {}});
-  }
   return true;
 }
 
 optional<IdType> ContextFreeGrammar::FindProd(const Production::TokenVec &token_vec) const {
-  auto it = find_if(
-    productions_.begin(), productions_.end(),
-    [&token_vec](const Production &prod) { return prod.GetTokens() == token_vec; });
-  if (it == productions_.end())
+  auto it = prod_id_map_.find(token_vec);
+  if (it == prod_id_map_.end())
     return {};
   
-  return distance(productions_.begin(), it);
+  return it->second;
 }
 
 const vector<Token> &ContextFreeGrammar::GetNonTerminators() const {
@@ -212,8 +212,10 @@ bool LRItem::operator==(const LRItem &rhs) const {
   return tokens_ == rhs.tokens_ && look_ahead_ == rhs.look_ahead_ && current_position_ == rhs.current_position_;
 }
 
-LRItem::LRItem(Production::TokenVec tos, Production::TokenSet las, size_t cur_pos) :
-  tokens_(std::move(tos)), look_ahead_(move(las)), current_position_(cur_pos) {
+LRItem::LRItem(Production::TokenVec tos, Production::TokenSet las, size_t cur_pos,
+               optional<IdType> prod_id) :
+  tokens_(std::move(tos)), look_ahead_(move(las)), current_position_(cur_pos),
+  production_id_(prod_id) {
   for (const auto &t: las) {
     if (t.GetTokenType() != Token::Type::kTerminator)
       throw runtime_error("Found non-term in Look Ahead!");
@@ -227,7 +229,7 @@ optional<LRItem> LRItem::Defer(const Token &tok) const {
   if (!(tokens_[current_position_ + 1] == tok))
     return {};
   
-  return make_optional(move(LRItem(tokens_, look_ahead_, current_position_ + 1)));
+  return make_optional(move(LRItem(tokens_, look_ahead_, current_position_ + 1, production_id_)));
 }
 
 const Production::TokenVec &LRItem::GetTokens() const {
@@ -242,6 +244,10 @@ size_t LRItem::GetCurrentPosition() const {
   return current_position_;
 }
 
+optional<IdType> LRItem::GetProductionId() const {
+  return production_id_;
+}
+
 optional<Token> LRItem::Next() const {
   if (current_position_ + 1 < tokens_.size())
     return tokens_[current_position_ + 1];
@@ -0,0 +1,94 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#include <sly/DenseParsingTable.h>
+#include <sly/utils.h>
+#include <stdexcept>
+
+namespace sly::core::grammar {
+
+DenseParsingTable::DenseParsingTable(const ParsingTable &table) {
+  const auto &action_table = table.GetActionTable();
+  const auto &goto_table = table.GetGotoTable();
+  const auto &productions = table.GetProductions();
+  n_states_ = action_table.size();
+  if (goto_table.size() != n_states_)
+    throw runtime_error("Action table and goto table differ in size!");
+
+  // 1. 编号：先终结符，后非终结符
+  vector<Token> non_terminators;
+  auto put_symbol = [this, &non_terminators](const Token &tok) {
+    if (tok.GetTokenType() == Token::Type::kEpsilon ||
+        symbol_id_.find(tok) != symbol_id_.end())
+      return;
+    if (tok.GetTokenType() == Token::Type::kTerminator) {
+      symbol_id_.insert({tok, static_cast<int>(symbols_.size())});
+      symbols_.push_back(tok);
+    } else {
+      symbol_id_.insert({tok, -1});
+      non_terminators.push_back(tok);
+    }
+  };
+  for (const auto &prod : productions) {
+    for (const auto &tok : prod.GetTokens())
+      put_symbol(tok);
+  }
+  put_symbol(table.GetEndingToken());
+  for (const auto &line : action_table) {
+    for (const auto &[tok, cell] : line)
+      put_symbol(tok);
+  }
+  for (const auto &line : goto_table) {
+    for (const auto &[tok, go] : line)
+      put_symbol(tok);
+  }
+  n_terminators_ = symbols_.size();
+  for (const auto &tok : non_terminators) {
+    symbol_id_[tok] = static_cast<int>(symbols_.size());
+    symbols_.push_back(tok);
+  }
+  n_symbols_ = symbols_.size();
+
+  // 2. 填表，未出现的格子均为 kError
+  cells_.assign(n_states_ * n_symbols_, Encode(ParsingTable::kError, 0));
+  for (IdType i = 0; i < n_states_; ++i) {
+    uint32_t *row = cells_.data() + i * n_symbols_;
+    for (const auto &[tok, cell] : action_table[i]) {
+      if (tok.GetTokenType() == Token::Type::kEpsilon || cell.empty())
+        continue;
+      if (cell.size() == 1)
+        row[symbol_id_.at(tok)] = Encode(cell.front().action, cell.front().id);
+      else
+        row[symbol_id_.at(tok)] = Encode(ParsingTable::kEmpty, 0);
+    }
+    for (const auto &[tok, go] : goto_table[i]) {
+      if (go.empty())
+        continue;
+      if (go.size() == 1)
+        row[symbol_id_.at(tok)] = Encode(ParsingTable::kShiftIn, go.front());
+      else
+        row[symbol_id_.at(tok)] = Encode(ParsingTable::kEmpty, 0);
+    }
+  }
+
+  // 3. 产生式只保留规约需要的左部和右部长度
+  lhs_.reserve(productions.size());
+  rhs_length_.reserve(productions.size());
+  for (const auto &prod : productions) {
+    lhs_.push_back(symbol_id_.at(prod.GetTokens().front()));
+    rhs_length_.push_back(prod.GetTokens().size() - 1);
+  }
+}
+
+const vector<Token> &DenseParsingTable::GetSymbols() const { return symbols_; }
+
+uint32_t DenseParsingTable::Encode(ParsingTable::AutomataAction action,
+                                   IdType id) {
+  if (id > (UINT32_MAX >> kActionBits))
+    throw runtime_error("Parsing table id out of range!");
+  return static_cast<uint32_t>(id << kActionBits) |
+         static_cast<uint32_t>(action);
+}
+
+} // namespace sly::core::grammar
@@ -9,6 +9,7 @@
 #include <sly/FaModel.h>
 #include <sly/TableGenerateMethod.h>
 #include <sly/utils.h>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 namespace sly::core::lexical {
@@ -314,76 +315,208 @@ NfaModel operator*(const NfaModel &na, const NfaModel &nb) {
 NfaModel operator++(const NfaModel &na) { return na.ToClosure(); }
 
 pair<vector<vector<int>>, vector<int>> DfaModel::Merge(const std::vector<DfaModel> &dfa_list) {
-  vector<vector<int>> transitions;
-  vector<int> accept;
-  // treat these dfa as nfa and merge
+  MergedDfaModel merged(dfa_list);
+  return {merged.GetTransition(), merged.GetAcceptStates()};
+}
+
+namespace {
+// 乘积状态（以及投影状态）的哈希
+struct StateVecHash {
+  size_t operator()(const vector<int> &v) const {
+    size_t hv = v.size();
+    for (auto s : v) {
+      hv ^= static_cast<size_t>(s + 1) + 0x9e3779b97f4a7c15ULL + (hv << 6) + (hv >> 2);
+    }
+    return hv;
+  }
+};
+
+struct StatePairHash {
+  size_t operator()(const pair<int, int> &p) const {
+    return (static_cast<size_t>(p.first) << 32) ^ static_cast<size_t>(p.second + 1);
+  }
+};
+} // namespace
+
+MergedDfaModel::MergedDfaModel(std::vector<DfaModel> dfa_list)
+    : dfa_list_(std::move(dfa_list)) {
   // states[i] == id >=  0 表示第 i 个 dfa 状态为 id
   //              id == -1 表示第 i 个 dfa 已经退出
-  vector<vector<int>> states;
-  states.emplace_back();
-  for (const auto & dfa: dfa_list) {
-    states.front().push_back(dfa.entry_);
+  states_.emplace_back();
+  for (const auto &dfa : dfa_list_) {
+    states_.front().push_back(dfa.entry_);
   }
-  
-  auto determine_can_accept = [&dfa_list](const vector<int> &state) {
-    for (int i = 0; i < dfa_list.size(); ++i) {
-      if (state[i] < 0 || state[i] >= dfa_list[i].states_.size())
-        continue;
-      if (dfa_list[i].states_[state[i]]) {
-        return i;
-      }
-    }
-    return -1;
-  };
+  unordered_map<vector<int>, int, StateVecHash> state_id{{states_.front(), 0}};
   // 扩展状态直到收敛
-  for (int i = 0; i < states.size(); ++i) {
-    // 获取当前状态
-    vector<int> current = states[i];
-    spdlog::debug("state {}", i);
+  for (size_t i = 0; i < states_.size(); ++i) {
     // 在返回值中添加状态是否可以作为结束的标记
-    accept.push_back(determine_can_accept(current));
+    accept_.push_back(DetermineAccept(states_[i]));
     vector<int> tran(128, -1);
-    // 对所有转义字符执行转移
-    set<char> charset;
-    for(int i = 0; i < dfa_list.size(); ++i) {
-      if (current[i] != -1) {
-        for (const auto& [k, v]: dfa_list[i].GetTransition()[current[i]]) {
-          charset.emplace(k);
+    for (int c = 0; c < 128; ++c) {
+      vector<int> target(dfa_list_.size(), -1);
+      bool alive = false;
+      for (size_t j = 0; j < dfa_list_.size(); ++j) {
+        int s = states_[i][j];
+        if (s == -1)
+          continue;
+        const auto &tr = dfa_list_[j].transition_[s];
+        if (auto it = tr.find(static_cast<char>(c)); it != tr.end()) {
+          target[j] = it->second;
+          alive = true;
         }
       }
+      if (!alive)
+        continue;
+      auto [it, inserted] = state_id.emplace(target, (int)states_.size());
+      if (inserted) {
+        states_.emplace_back(move(target));
+      }
+      tran[c] = it->second;
     }
-    for (auto c: charset) {
-      vector<int> transition_target_state;
-      for (int i = 0; i < dfa_list.size(); ++i) {
-        const auto& dfa = dfa_list[i];
-        const auto& state = current[i];
-        if (state == -1) {
-          transition_target_state.emplace_back(-1);
-        } else {
-          if (const auto &it = dfa.transition_[state].find(c);
-              it != dfa.transition_[state].end()) {
-            transition_target_state.emplace_back(it->second);
-          } else {
-            transition_target_state.emplace_back(-1);
-          }
-        }
+    transition_.emplace_back(move(tran));
+  }
+  rederived_count_ = states_.size();
+}
+
+int MergedDfaModel::DetermineAccept(const vector<int> &state) const {
+  for (size_t i = 0; i < dfa_list_.size(); ++i) {
+    if (state[i] < 0 || state[i] >= static_cast<int>(dfa_list_[i].states_.size()))
+      continue;
+    if (dfa_list_[i].states_[state[i]]) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void MergedDfaModel::AddRule(DfaModel dfa) {
+  InsertRule(dfa_list_.size(), move(dfa));
+}
+
+void MergedDfaModel::InsertRule(size_t pos, DfaModel dfa) {
+  if (pos > dfa_list_.size())
+    throw out_of_range("MergedDfaModel::InsertRule: pos out of range.");
+  dfa_list_.insert(dfa_list_.begin() + static_cast<long>(pos), move(dfa));
+  Rederive(pos, &dfa_list_[pos], false);
+}
+
+void MergedDfaModel::RemoveRule(size_t pos) {
+  if (pos >= dfa_list_.size())
+    throw out_of_range("MergedDfaModel::RemoveRule: pos out of range.");
+  dfa_list_.erase(dfa_list_.begin() + static_cast<long>(pos));
+  Rederive(pos, nullptr, true);
+}
+
+void MergedDfaModel::ReplaceRule(size_t pos, DfaModel dfa) {
+  if (pos >= dfa_list_.size())
+    throw out_of_range("MergedDfaModel::ReplaceRule: pos out of range.");
+  dfa_list_[pos] = move(dfa);
+  Rederive(pos, &dfa_list_[pos], true);
+}
+
+void MergedDfaModel::Rederive(size_t pos, const DfaModel *p_dfa, bool had_old) {
+  // 1. 把旧的乘积状态投影到其余规则上。其余规则的转移与第 pos 条无关，
+  //    因此投影自动机的转移可以直接由旧表得到，不需要重新确定化。
+  vector<vector<int>> proj_states;
+  unordered_map<vector<int>, int, StateVecHash> proj_id;
+  auto project = [&](const vector<int> &state) {
+    vector<int> p(state);
+    if (had_old)
+      p.erase(p.begin() + static_cast<long>(pos));
+    auto [it, inserted] = proj_id.emplace(p, (int)proj_states.size());
+    if (inserted)
+      proj_states.emplace_back(move(p));
+    return it->second;
+  };
+  // 旧状态 -> 投影编号
+  vector<int> old2proj;
+  old2proj.reserve(states_.size());
+  for (const auto &s : states_) {
+    old2proj.push_back(project(s));
+  }
+  // 全部退出的投影状态
+  size_t n_other = dfa_list_.size() - (p_dfa ? 1 : 0);
+  int dead = project(vector<int>(n_other + (had_old ? 1 : 0), -1));
+  vector<vector<int>> proj_tran(proj_states.size());
+  for (size_t i = 0; i < states_.size(); ++i) {
+    auto &row = proj_tran[old2proj[i]];
+    if (!row.empty())
+      continue;
+    row.resize(128, dead);
+    for (int c = 0; c < 128; ++c) {
+      if (transition_[i][c] >= 0)
+        row[c] = old2proj[transition_[i][c]];
+    }
+  }
+  proj_tran[dead] = vector<int>(128, dead);
+
+  // 投影状态在新编号中的 accept（不含第 pos 条规则）
+  auto rule_id = [pos, p_dfa](size_t j) {
+    return static_cast<int>((p_dfa && j >= pos) ? j + 1 : j);
+  };
+  vector<int> proj_accept(proj_states.size(), -1);
+  for (size_t i = 0; i < proj_states.size(); ++i) {
+    for (size_t j = 0; j < proj_states[i].size(); ++j) {
+      int s = proj_states[i][j];
+      const auto &dfa = dfa_list_[rule_id(j)];
+      if (s >= 0 && s < static_cast<int>(dfa.states_.size()) && dfa.states_[s]) {
+        proj_accept[i] = rule_id(j);
+        break;
       }
-      // 检查状态
-      if (auto it = find(cbegin(states), cend(states), transition_target_state);
-          it != states.end()) {
-        // 说明转移到了 id 处
-        auto id = distance(states.cbegin(), it);
-        tran[c] = id;
-      } else {
-        // 新状态
-        auto id = states.size();
-        states.emplace_back(move(transition_target_state));
-        tran[c] = id;
+    }
+  }
+
+  // 2. 以 (投影状态, 第 pos 条规则的状态) 为新的乘积状态重新展开。
+  //    第 pos 个分量已退出的状态直接沿用投影的转移。
+  vector<pair<int, int>> states{{old2proj[0], p_dfa ? DfaModel::entry_ : -1}};
+  unordered_map<pair<int, int>, int, StatePairHash> state_id{{states.front(), 0}};
+  transition_.clear();
+  accept_.clear();
+  rederived_count_ = 0;
+  for (size_t i = 0; i < states.size(); ++i) {
+    auto [p, q] = states[i];
+    int acc = proj_accept[p];
+    if (q >= 0 && p_dfa->states_[q] && (acc < 0 || acc > (int)pos))
+      acc = (int)pos;
+    accept_.push_back(acc);
+    const map<char, int> *q_tran = q >= 0 ? &p_dfa->transition_[q] : nullptr;
+    if (q_tran)
+      rederived_count_ += 1;
+    vector<int> tran(128, -1);
+    for (int c = 0; c < 128; ++c) {
+      int np = proj_tran[p][c], nq = -1;
+      if (q_tran) {
+        if (auto it = q_tran->find(static_cast<char>(c)); it != q_tran->end())
+          nq = it->second;
       }
+      if (np == dead && nq == -1)
+        continue;
+      auto [it, inserted] = state_id.emplace(make_pair(np, nq), (int)states.size());
+      if (inserted)
+        states.emplace_back(np, nq);
+      tran[c] = it->second;
     }
-    transitions.emplace_back(move(tran));
+    transition_.emplace_back(move(tran));
+  }
+
+  // 3. 还原完整的乘积状态
+  states_.clear();
+  for (auto [p, q] : states) {
+    vector<int> s = proj_states[p];
+    if (p_dfa)
+      s.insert(s.begin() + static_cast<long>(pos), q);
+    states_.emplace_back(move(s));
   }
-  return {transitions, accept};
 }
 
+const vector<vector<int>> &MergedDfaModel::GetTransition() const {
+  return transition_;
+}
+
+const vector<int> &MergedDfaModel::GetAcceptStates() const { return accept_; }
+
+const vector<DfaModel> &MergedDfaModel::GetDfaList() const { return dfa_list_; }
+
+size_t MergedDfaModel::GetRederivedCount() const { return rederived_count_; }
+
 } // namespace sly::core::lexical
\ No newline at end of file
@@ -0,0 +1,216 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#include <sly/GrammarIndex.h>
+#include <sly/utils.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace sly::core::grammar {
+
+namespace {
+
+class DigraphTraversal {
+ public:
+  DigraphTraversal(const vector<vector<int>> &relation,
+                   vector<TerminalSet> &sets)
+      : relation_(relation), sets_(sets), depth_(relation.size(), 0) {}
+
+  void Run() {
+    for (size_t x = 0; x < relation_.size(); ++x) {
+      if (depth_[x] == 0)
+        Traverse(static_cast<int>(x));
+    }
+  }
+
+ private:
+  void Traverse(int x) {
+    stack_.push_back(x);
+    const size_t d = stack_.size();
+    depth_[x] = d;
+    for (int y : relation_[x]) {
+      if (depth_[y] == 0)
+        Traverse(y);
+      depth_[x] = min(depth_[x], depth_[y]);
+      sets_[x].Merge(sets_[y]);
+    }
+    if (depth_[x] == d) {
+      while (true) {
+        int top = stack_.back();
+        stack_.pop_back();
+        depth_[top] = SIZE_MAX;
+        if (top == x)
+          break;
+        sets_[top] = sets_[x];
+      }
+    }
+  }
+
+  const vector<vector<int>> &relation_;
+
+  vector<TerminalSet> &sets_;
+
+  // 0 为未访问，SIZE_MAX 为已完成
+  vector<size_t> depth_;
+
+  vector<int> stack_;
+};
+
+} // namespace
+
+void Digraph(const vector<vector<int>> &relation, vector<TerminalSet> &sets) {
+  DigraphTraversal(relation, sets).Run();
+}
+
+GrammarIndex::GrammarIndex(const ContextFreeGrammar &cfg) : cfg_(cfg) {
+  for (const auto &tok : cfg.GetTerminators()) {
+    symbol_id_.insert({tok, static_cast<int>(symbols_.size())});
+    symbols_.push_back(tok);
+  }
+  n_terminators_ = symbols_.size();
+  for (const auto &tok : cfg.GetNonTerminators()) {
+    symbol_id_.insert({tok, static_cast<int>(symbols_.size())});
+    symbols_.push_back(tok);
+  }
+
+  const auto &productions = cfg.GetProductions();
+  prods_of_.assign(symbols_.size() - n_terminators_, {});
+  for (IdType p = 0; p < productions.size(); ++p) {
+    const auto &tokens = productions[p].GetTokens();
+    lhs_.push_back(symbol_id_.at(tokens.front()));
+    rhs_.emplace_back();
+    for (auto it = tokens.cbegin() + 1; it != tokens.cend(); ++it) {
+      if (it->GetTokenType() != Token::Type::kEpsilon)
+        rhs_.back().push_back(symbol_id_.at(*it));
+    }
+    prods_of_[lhs_.back() - n_terminators_].push_back(p);
+  }
+
+  // 1. 可空性：记录每个产生式右部中尚未确定可空的符号数，降为 0 时左部可空
+  nullable_.assign(symbols_.size(), false);
+  vector<size_t> remaining(rhs_.size());
+  vector<vector<IdType>> occurrences(symbols_.size());
+  vector<int> work;
+  for (IdType p = 0; p < rhs_.size(); ++p) {
+    remaining[p] = rhs_[p].size();
+    for (int sym : rhs_[p])
+      occurrences[sym].push_back(p);
+    if (remaining[p] == 0 && !nullable_[lhs_[p]]) {
+      nullable_[lhs_[p]] = true;
+      work.push_back(lhs_[p]);
+    }
+  }
+  while (!work.empty()) {
+    int sym = work.back();
+    work.pop_back();
+    for (auto p : occurrences[sym]) {
+      if (--remaining[p] == 0 && !nullable_[lhs_[p]]) {
+        nullable_[lhs_[p]] = true;
+        work.push_back(lhs_[p]);
+      }
+    }
+  }
+
+  // 2. FIRST：X -> αYβ 且 α 可空时 FIRST(X) 包含 FIRST(Y)
+  vector<vector<int>> first_relation(symbols_.size());
+  for (IdType p = 0; p < rhs_.size(); ++p) {
+    for (int sym : rhs_[p]) {
+      first_relation[lhs_[p]].push_back(sym);
+      if (!nullable_[sym])
+        break;
+    }
+  }
+  first_.assign(symbols_.size(), TerminalSet(n_terminators_));
+  for (size_t t = 0; t < n_terminators_; ++t)
+    first_[t].Set(t);
+  Digraph(first_relation, first_);
+
+  // 3. 每个后缀的 FIRST 与可空性，从右向左递推
+  suffix_offset_.resize(rhs_.size());
+  size_t total = 0;
+  for (IdType p = 0; p < rhs_.size(); ++p) {
+    suffix_offset_[p] = total;
+    total += rhs_[p].size() + 1;
+  }
+  suffix_first_.assign(total, TerminalSet(n_terminators_));
+  suffix_nullable_.assign(total, false);
+  for (IdType p = 0; p < rhs_.size(); ++p) {
+    size_t base = suffix_offset_[p], n = rhs_[p].size();
+    suffix_nullable_[base + n] = true;
+    for (size_t pos = n; pos-- > 0;) {
+      int sym = rhs_[p][pos];
+      suffix_first_[base + pos] = first_[sym];
+      if (nullable_[sym]) {
+        suffix_first_[base + pos].Merge(suffix_first_[base + pos + 1]);
+        suffix_nullable_[base + pos] = suffix_nullable_[base + pos + 1];
+      }
+    }
+  }
+
+  // 4. FOLLOW：X -> αYβ 时 FOLLOW(Y) 包含 FIRST(β)，β 可空时还包含 FOLLOW(X)
+  vector<vector<int>> follow_relation(symbols_.size());
+  follow_.assign(symbols_.size(), TerminalSet(n_terminators_));
+  follow_[lhs_.front()].Set(symbol_id_.at(cfg.GetEndingToken()));
+  for (IdType p = 0; p < rhs_.size(); ++p) {
+    for (size_t pos = 0; pos < rhs_[p].size(); ++pos) {
+      int sym = rhs_[p][pos];
+      if (IsTerminator(sym))
+        continue;
+      follow_[sym].Merge(GetFirst(p, pos + 1));
+      if (IsNullable(p, pos + 1))
+        follow_relation[sym].push_back(lhs_[p]);
+    }
+  }
+  Digraph(follow_relation, follow_);
+}
+
+LRItem GrammarIndex::MakeItem(IdType prod, size_t dot,
+                              const TerminalSet &look_ahead) const {
+  const auto &tokens = cfg_.GetProductions()[prod].GetTokens();
+  Production::TokenSet las;
+  look_ahead.ForEach([this, &las](size_t t) { las.insert(symbols_[t]); });
+  size_t position = rhs_[prod].empty() ? tokens.size() - 1 : dot;
+  return LRItem(tokens, las, position, prod);
+}
+
+vector<pair<GrammarIndex::Item, TerminalSet>>
+GrammarIndex::Lr1Closure(const vector<Item> &kernel,
+                         const vector<TerminalSet> &look_ahead) const {
+  vector<pair<Item, TerminalSet>> items;
+  // 圆点在最左的项目在 items 中的位置；只有初始状态的核心项目圆点在最左，
+  // 且其产生式 S' -> S 不会作为非核心项目出现
+  vector<int> index(GetProductionCount(), -1);
+  for (size_t k = 0; k < kernel.size(); ++k) {
+    items.emplace_back(kernel[k], look_ahead[k]);
+    if (kernel[k].second == 0)
+      index[kernel[k].first] = static_cast<int>(k);
+  }
+  // 向前看符号有变化的项目需要重新向后传播
+  vector<size_t> work(items.size());
+  for (size_t k = 0; k < work.size(); ++k)
+    work[k] = work.size() - 1 - k;
+  while (!work.empty()) {
+    size_t k = work.back();
+    work.pop_back();
+    auto [p, dot] = items[k].first;
+    const auto &rhs = rhs_[p];
+    if (dot >= rhs.size() || IsTerminator(rhs[dot]))
+      continue;
+    TerminalSet first = GetFirst(p, dot + 1);
+    if (IsNullable(p, dot + 1))
+      first.Merge(items[k].second);
+    for (auto q : GetProductionsOf(rhs[dot])) {
+      if (index[q] < 0) {
+        index[q] = static_cast<int>(items.size());
+        items.emplace_back(Item{q, 0}, first);
+        work.push_back(index[q]);
+      } else if (items[index[q]].second.Merge(first)) {
+        work.push_back(index[q]);
+      }
+    }
+  }
+  return items;
+}
+
+} // namespace sly::core::grammar
@@ -0,0 +1,66 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#include <sly/InputBuffer.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+
+namespace sly::runtime {
+
+InputBuffer::InputBuffer(std::istream *in, size_t capacity)
+    : in_(in), data_(capacity + 1, '\0') {
+  assert(capacity > 0);
+}
+
+const char *InputBuffer::Data() const { return data_.data(); }
+
+char *InputBuffer::Data() { return data_.data(); }
+
+size_t InputBuffer::Size() const { return size_; }
+
+size_t InputBuffer::Capacity() const { return data_.size() - 1; }
+
+bool InputBuffer::Eof() const { return eof_; }
+
+size_t InputBuffer::Refill(size_t keep) {
+  assert(keep <= size_);
+  if (keep > 0) {
+    std::memmove(data_.data(), data_.data() + keep, size_ - keep);
+    size_ -= keep;
+  }
+  if (eof_ || in_ == nullptr) {
+    data_[size_] = '\0';
+    return 0;
+  }
+  if (size_ == Capacity()) {
+    // 单个词法单元占满了整个缓冲区
+    data_.resize(2 * Capacity() + 1);
+  }
+  // 只为第一个字节阻塞，之后只取已经到达的字节：
+  // 交互式输入（终端、管道）不必等到整个缓冲区读满才产生词法单元
+  char *dst = data_.data() + size_;
+  auto room = static_cast<std::streamsize>(Capacity() - size_);
+  std::streamsize count = 0;
+  auto *buf = in_->good() ? in_->rdbuf() : nullptr;
+  int c = buf == nullptr ? EOF : buf->sbumpc();
+  if (c != EOF) {
+    dst[count++] = static_cast<char>(c);
+    while (count < room) {
+      std::streamsize avail = buf->in_avail();
+      if (avail <= 0)
+        break;
+      count += buf->sgetn(dst + count, std::min(avail, room - count));
+    }
+  }
+  eof_ = count == 0;
+  if (eof_)
+    in_->setstate(std::ios::eofbit);
+  size_ += static_cast<size_t>(count);
+  data_[size_] = '\0';
+  return static_cast<size_t>(count);
+}
+
+}
@@ -0,0 +1,148 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#include <sly/KeywordTable.h>
+#include <sly/utils.h>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <unordered_set>
+
+
+namespace sly::runtime {
+
+using core::lexical::DfaModel;
+
+KeywordTable::KeywordTable(const std::vector<std::pair<std::string, int>> &keywords)
+    : size_(keywords.size()) {
+  if (keywords.empty())
+    return;
+  // 相同的关键字无法用任何种子分开，空串没有首、尾字符
+  std::unordered_set<std::string> seen;
+  for (const auto &[text, rule] : keywords) {
+    if (text.empty() || !seen.insert(text).second) {
+      spdlog::error("Keyword table: empty or duplicated keyword \"{}\".", text);
+      throw std::runtime_error("Invalid keyword list.");
+    }
+  }
+  min_length_ = SIZE_MAX;
+  for (const auto &[text, rule] : keywords) {
+    min_length_ = std::min(min_length_, text.size());
+    max_length_ = std::max(max_length_, text.size());
+  }
+  // 从不小于 2 倍关键字数的 2 的幂开始尝试种子，全部冲突时把槽位数加倍，
+  // 槽位数超过关键字数的 64 倍仍然冲突时改为对整个字符串求散列
+  size_t capacity = 1;
+  while (capacity < 2 * keywords.size())
+    capacity <<= 1;
+  for (;; capacity <<= 1) {
+    if (capacity > 64 * keywords.size() && !full_hash_) {
+      full_hash_ = true;
+      capacity >>= 5;
+    }
+    mask_ = capacity - 1;
+    uint32_t random = 20220330;
+    for (int attempt = 0; attempt < 4096; ++attempt) {
+      random = random * 1664525u + 1013904223u;
+      seed_ = random | 1u;
+      rules_.assign(capacity, -1);
+      bool collided = false;
+      for (const auto &[text, rule] : keywords) {
+        size_t slot = Hash(text.data(), text.size()) & mask_;
+        if (rules_[slot] >= 0) {
+          collided = true;
+          break;
+        }
+        rules_[slot] = rule;
+      }
+      if (!collided) {
+        slots_.assign(capacity, std::string());
+        for (const auto &[text, rule] : keywords) {
+          slots_[Hash(text.data(), text.size()) & mask_] = text;
+        }
+        SLY_LOG_DEBUG("keyword table: {} keywords, {} slots, seed {}, full hash {}",
+                      keywords.size(), capacity, seed_, full_hash_);
+        return;
+      }
+    }
+  }
+}
+
+std::vector<std::pair<std::string, int>> KeywordTable::GetKeywords() const {
+  std::vector<std::pair<std::string, int>> keywords;
+  for (size_t slot = 0; slot < slots_.size(); ++slot) {
+    if (rules_[slot] >= 0)
+      keywords.emplace_back(slots_[slot], rules_[slot]);
+  }
+  std::sort(keywords.begin(), keywords.end(),
+            [](const auto &a, const auto &b) { return a.second < b.second; });
+  return keywords;
+}
+
+namespace {
+
+/**
+ * 规则只接受一个字符串时返回该字符串：从入口出发，每个非接受状态恰有一条转移，
+ * 接受状态没有转移
+ */
+std::optional<std::string> LiteralOf(const DfaModel &dfa) {
+  const auto &states = dfa.GetStates();
+  const auto &transition = dfa.GetTransition();
+  std::string text;
+  int state = DfaModel::entry_;
+  while (text.size() <= states.size()) {
+    if (states[state])
+      return transition[state].empty() ? std::optional(text) : std::nullopt;
+    if (transition[state].size() != 1)
+      return std::nullopt;
+    auto [c, next] = *transition[state].begin();
+    text.push_back(c);
+    state = next;
+  }
+  return std::nullopt;
+}
+
+bool Accepts(const DfaModel &dfa, const std::string &text) {
+  int state = DfaModel::entry_;
+  for (char c : text) {
+    auto next = dfa.Defer(state, c);
+    if (!next.has_value())
+      return false;
+    state = next.value();
+  }
+  return dfa.GetStates()[state];
+}
+
+}
+
+std::pair<std::vector<int>, KeywordTable>
+KeywordTable::Extract(const std::vector<DfaModel> &dfa_list,
+                      const std::vector<int> &rules) {
+  std::vector<std::optional<std::string>> literals;
+  literals.reserve(rules.size());
+  for (int rule : rules) {
+    literals.push_back(LiteralOf(dfa_list[rule]));
+  }
+  std::vector<int> kept;
+  std::vector<std::pair<std::string, int>> keywords;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    bool shadowed = false;
+    if (literals[i].has_value() && !literals[i]->empty() &&
+        std::none_of(keywords.begin(), keywords.end(),
+                     [&](const auto &k) { return k.first == *literals[i]; })) {
+      // 只看不会被分离出去的规则，保证去掉关键字后仍有规则接受该字符串
+      for (size_t j = 0; j < rules.size() && !shadowed; ++j) {
+        shadowed = j != i && !literals[j].has_value() &&
+                   Accepts(dfa_list[rules[j]], *literals[i]);
+      }
+    }
+    if (shadowed)
+      keywords.emplace_back(*literals[i], rules[i]);
+    else
+      kept.push_back(rules[i]);
+  }
+  return {std::move(kept), KeywordTable(keywords)};
+}
+
+}
@@ -0,0 +1,102 @@
+//
+// Created by Yang Jerry on 2022/3/30.
+//
+
+#include <sly/LineIndex.h>
+#include <algorithm>
+#include <cassert>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace sly::runtime {
+
+LineIndex::LineIndex() : line_starts_{0} {}
+
+void LineIndex::Extend(const char *data, size_t size) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // 每次比较 16 个字节，只有包含换行符或制表符的块才逐位处理
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i tab = _mm_set1_epi8('\t');
+  for (; i + 16 <= size; i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    auto nl_mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+    auto tab_mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, tab)));
+    if ((nl_mask | tab_mask) == 0)
+      continue;
+    for (unsigned mask = nl_mask | tab_mask; mask != 0; mask &= mask - 1) {
+      unsigned bit = __builtin_ctz(mask);
+      size_t offset = indexed_ + i + bit;
+      if (nl_mask & (1u << bit))
+        line_starts_.push_back(offset + 1);
+      else
+        tabs_.push_back(offset);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (data[i] == '\n')
+      line_starts_.push_back(indexed_ + i + 1);
+    else if (data[i] == '\t')
+      tabs_.push_back(indexed_ + i);
+  }
+  indexed_ += size;
+}
+
+void LineIndex::Truncate(size_t offset) {
+  if (offset >= indexed_)
+    return;
+  // 第 1 行的行首 0 始终保留
+  line_starts_.erase(std::upper_bound(line_starts_.begin() + 1,
+                                      line_starts_.end(), offset),
+                     line_starts_.end());
+  tabs_.erase(std::lower_bound(tabs_.begin(), tabs_.end(), offset),
+              tabs_.end());
+  indexed_ = offset;
+  last_line_ = 0;
+}
+
+size_t LineIndex::Indexed() const { return indexed_; }
+
+core::type::SourceLocation LineIndex::Locate(size_t offset) const {
+  assert(offset <= indexed_);
+  // 按偏移递增查询时，目标通常在上次查询的行或下一行
+  auto in_line = [this, offset](size_t line) {
+    return line < line_starts_.size() && line_starts_[line] <= offset &&
+           (line + 1 == line_starts_.size() || offset < line_starts_[line + 1]);
+  };
+  size_t line = last_line_;
+  if (!in_line(line)) {
+    if (in_line(line + 1))
+      line += 1;
+    else
+      line = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset) -
+             line_starts_.begin() - 1;
+  }
+  last_line_ = line;
+  size_t start = line_starts_[line];
+  // 行首到 offset 之间的制表符
+  size_t col = 1;
+  size_t pos = start;
+  for (auto t = std::lower_bound(tabs_.begin(), tabs_.end(), start);
+       t != tabs_.end() && *t < offset; ++t) {
+    col += *t - pos;
+    col += 8 - ((col - 1) % 8);
+    pos = *t + 1;
+  }
+  col += offset - pos;
+  return {static_cast<uint32_t>(line + 1), static_cast<uint32_t>(col)};
+}
+
+void LineIndex::Clear() {
+  line_starts_.assign(1, 0);
+  tabs_.clear();
+  indexed_ = 0;
+  last_line_ = 0;
+}
+
+}
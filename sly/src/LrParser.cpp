@@ -9,11 +9,36 @@ namespace sly::core::grammar {
 
 const ParsingTable &LrParser::GetPt() const { return pt_; }
 
-void LrParser::SetPt(const ParsingTable &pt) { pt_ = pt; }
+void LrParser::SetPt(const ParsingTable &pt) {
+  pt_ = pt;
+  dense_ = DenseParsingTable(pt_);
+  if (table_kind_ == ParsingTableKind::kCompressed)
+    compressed_ = CompressedParsingTable(dense_);
+  symbol_offset_ = static_cast<IdType>(-1);
+}
+
+void LrParser::SetTableKind(ParsingTableKind kind) {
+  if (kind == ParsingTableKind::kCompressed &&
+      table_kind_ != ParsingTableKind::kCompressed)
+    compressed_ = CompressedParsingTable(dense_);
+  table_kind_ = kind;
+}
+
+DenseParsingTable::Cell LrParser::LookupAction(IdType state, int symbol) const {
+  if (table_kind_ == ParsingTableKind::kCompressed)
+    return compressed_.GetAction(state, symbol);
+  return dense_.GetAction(state, symbol);
+}
+
+int LrParser::LookupGoto(IdType state, int symbol) const {
+  if (table_kind_ == ParsingTableKind::kCompressed)
+    return compressed_.GetGoto(state, symbol);
+  return dense_.GetGoto(state, symbol);
+}
 
 LrParser::LrParser(ParsingTable &parsing_table)
-    : pt_(parsing_table), current_state_id_(-1), current_offset_(0),
-      state_stack_(1, 0) {}
+    : pt_(parsing_table), dense_(parsing_table), current_state_id_(-1),
+      current_offset_(0), state_stack_(1, 0) {}
 
 void LrParser::Parse(vector<Token> token_stream,
                      vector<YYSTATE> yylval_stream) {
@@ -28,6 +53,7 @@ void LrParser::Parse(vector<Token> token_stream,
   apt_stack_.clear();
   state_stack_.clear();
   current_offset_ = 0;
+  symbol_offset_ = static_cast<IdType>(-1);
   state_stack_ = std::deque<IdType>(1, 0);
   accepted_ = false;
   while (current_offset_ < token_stream.size() && !accepted_) {
@@ -60,12 +86,28 @@ void LrParser::ParseOnce(const vector<Token> &token_stream,
     current_offset_ += 1;
     return;
   } else if (current_token.GetTokenType() == Token::Type::kTerminator) {
-    const auto &act = pt_.GetAction(state_stack_.back(), current_token);
-    if (act.size() != 1) {
-      spdlog::error("Found invalid action table.");
-      throw runtime_error("Found invalid action table.");
+    // 压缩表中只有默认规约的状态直接规约，不查看向前看符号
+    int forced = table_kind_ == ParsingTableKind::kCompressed
+                     ? compressed_.GetForcedReduction(state_stack_.back())
+                     : -1;
+    DenseParsingTable::Cell action{ParsingTable::kReduce,
+                                   static_cast<IdType>(forced)};
+    if (forced < 0) {
+      if (symbol_offset_ != current_offset_) {
+        current_symbol_ = dense_.SymbolOf(current_token);
+        symbol_offset_ = current_offset_;
+      }
+      if (current_symbol_ < 0) {
+        // 文法中没有的终结符与其他语法错误一样报告
+        action = {ParsingTable::kError, 0};
+      } else {
+        action = LookupAction(state_stack_.back(), current_symbol_);
+        if (action.action == ParsingTable::kEmpty) {
+          spdlog::error("Found invalid action table.");
+          throw runtime_error("Found invalid action table.");
+        }
+      }
     }
-    const auto &action = act[0];
     if (action.action == ParsingTable::kShiftIn) {
       // 执行移入操作
       apt_stack_.emplace_back(current_token, yylval_stream[current_offset_]);
@@ -73,29 +115,28 @@ void LrParser::ParseOnce(const vector<Token> &token_stream,
       current_offset_ += 1;
       // 当前状态更新
       state_stack_.emplace_back(action.id);
-      spdlog::debug("Shift In [{}]], Go state {}", current_token.ToString(),
+      SLY_LOG_DEBUG("Shift In [{}]], Go state {}", current_token.ToString(),
                     state_stack_.back());
     } else if (action.action == ParsingTable::kReduce) {
       // 按照 id 进行规约
       const auto &prod = pt_.GetProductions()[action.id];
       AnnotatedParseTree apt(prod);
-      for (int i = 1; i < prod.GetTokens().size(); ++i) {
+      for (size_t i = dense_.GetRhsLength(action.id); i > 0; --i) {
         apt.EmplaceFront(move(apt_stack_.back()));
         apt_stack_.pop_back();
         state_stack_.pop_back();
       }
       apt_stack_.emplace_back(apt);
-      const auto &go =
-          pt_.GetGoto(state_stack_.back(), prod.GetTokens().front());
-      if (go.size() != 1) {
+      const auto go = LookupGoto(state_stack_.back(), dense_.GetLhs(action.id));
+      if (go < 0) {
         spdlog::error("Found invalid goto. from {} to {}", state_stack_.back(),
                       prod.GetTokens().front().ToString());
         throw runtime_error(fmt::format("Found invalid goto. from {} to {}",
                                         state_stack_.back(),
                                         prod.GetTokens().front().ToString()));
       }
-      state_stack_.emplace_back(go[0]);
-      spdlog::debug("Reduce [{}], Go state {}", current_token.ToString(),
+      state_stack_.emplace_back(go);
+      SLY_LOG_DEBUG("Reduce [{}], Go state {}", current_token.ToString(),
                     state_stack_.back());
 
     } else {
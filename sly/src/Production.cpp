@@ -46,6 +46,13 @@ bool Production::operator==(const Production &rhs) const {
   return tokens_ == rhs.tokens_ && actions_ == rhs.actions_;
 }
 
+std::size_t Production::TokenVecHash::operator()(const TokenVec &k) const {
+  size_t hv = 0;
+  for (const auto &tok : k)
+    hv = hv * 1000003 ^ Token::Hash{}(tok);
+  return hv;
+}
+
 Production::Production(Token start) : tokens_{start}, actions_{Action()} {}
 
 Production::Production(Token start, Action act)
@@ -3,10 +3,845 @@
 //
 
 #include <sly/SeuLex.h>
+#include <sly/utils.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_set>
+#include <unistd.h>
 
 
 namespace sly::runtime {
 
+MappedFile::MappedFile(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw runtime_error("Cannot open file: " + path);
+  struct stat st {};
+  if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    // 先保留多出至少一字节的匿名映射，再把文件映射到其开头，
+    // 文件末尾之后的字节均为 0，可以直接作为哨兵
+    size_t size = st.st_size;
+    auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t reserve = (size / page + 1) * page;
+    void *base = ::mmap(nullptr, reserve, PROT_READ,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED) {
+      void *p = ::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+      if (p != MAP_FAILED) {
+        ::madvise(p, size, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(p);
+        size_ = size;
+        mapped_size_ = reserve;
+      } else {
+        ::munmap(base, reserve);
+      }
+    }
+  }
+  if (data_ == nullptr) {
+    // 非普通文件或映射失败：读入内存
+    char buf[LEX_BUFFER_SIZE];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+      fallback_.append(buf, n);
+    }
+  }
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr)
+    ::munmap(const_cast<char *>(data_), mapped_size_);
+}
+
+std::string_view MappedFile::View() const {
+  if (data_ != nullptr)
+    return {data_, size_};
+  return fallback_;
+}
+
+SeuLex::SeuLex(const std::vector<std::vector<int>> &working_table,
+               std::vector<int> accept_states, std::vector<Token> corr_token,
+               Token end_token)
+    : tokens_(move(corr_token)), end_token_(move(end_token)) {
+  AddCondition(working_table, move(accept_states));
+}
+
+SeuLex::SeuLex(std::vector<Token> corr_token, Token end_token)
+    : tokens_(move(corr_token)), end_token_(move(end_token)) {}
+
+int SeuLex::AddCondition(const std::vector<std::vector<int>> &working_table,
+                         std::vector<int> accept_states, KeywordTable keywords) {
+  for (int rule : accept_states) {
+    if (rule < -1 || rule >= static_cast<int>(tokens_.size())) {
+      spdlog::error("AddCondition: accept rule {} is out of range, {} rules in total.",
+                    rule, tokens_.size());
+      throw runtime_error("Invalid accept states.");
+    }
+  }
+  auto &table = conditions_.emplace_back();
+  table.transition.reserve(working_table.size());
+  for (const auto &row : working_table) {
+    auto &line = table.transition.emplace_back();
+    line.fill(-1);
+    for (size_t c = 0; c < row.size() && c < 128; ++c) {
+      line[c] = row[c];
+    }
+    // '\0' 作为哨兵，与 Stream2TokenPipe 一样不参与匹配
+    line[0] = -1;
+  }
+  table.accept_states = move(accept_states);
+  table.keywords = move(keywords);
+  if (scan_loop_ == ScanLoop::kStride2)
+    BuildStride(table);
+  if (profiling_)
+    table.visits.assign(table.transition.size(), 0);
+  return static_cast<int>(conditions_.size()) - 1;
+}
+
+void SeuLex::BuildStride(ScanTable &table) {
+  const auto &transition = table.transition;
+  // 按列划分字节等价类
+  std::map<std::vector<int>, uint8_t> column_class;
+  std::vector<int> representative;
+  std::vector<int> column(transition.size());
+  for (int c = 0; c < 256; ++c) {
+    for (size_t s = 0; s < transition.size(); ++s) {
+      column[s] = transition[s][c];
+    }
+    auto [it, inserted] = column_class.emplace(column, column_class.size());
+    if (inserted)
+      representative.push_back(c);
+    table.classes[c] = it->second;
+  }
+  size_t k = table.class_count = representative.size();
+  size_t entries = transition.size() * k * k;
+  if (entries > STRIDE_TABLE_MAX_ENTRIES) {
+    SLY_LOG_DEBUG("stride table: {} states x {}^2 classes is too large", transition.size(), k);
+    table.stride.clear();
+    return;
+  }
+  table.stride.resize(entries);
+  for (size_t s = 0; s < transition.size(); ++s) {
+    for (size_t k0 = 0; k0 < k; ++k0) {
+      int middle = transition[s][representative[k0]];
+      for (size_t k1 = 0; k1 < k; ++k1) {
+        auto &entry = table.stride[(s * k + k0) * k + k1];
+        int next = middle < 0 ? -1 : transition[middle][representative[k1]];
+        entry.next = next;
+        entry.next_row = next < 0 ? -1 : static_cast<int>(next * k * k);
+        entry.middle_rule = next < 0 ? -1 : table.accept_states[middle];
+      }
+    }
+  }
+  SLY_LOG_DEBUG("stride table: {} states, {} byte classes, {} entries",
+                transition.size(), k, entries);
+}
+
+void SeuLex::SetProfiling(bool enable) {
+  profiling_ = enable;
+  if (!enable)
+    return;
+  for (auto &table : conditions_) {
+    table.visits.assign(table.transition.size(), 0);
+  }
+}
+
+const std::vector<uint64_t> &SeuLex::GetStateVisits(int condition) const {
+  return conditions_.at(condition).visits;
+}
+
+void SeuLex::Renumber(ScanTable &table) {
+  size_t n = table.transition.size();
+  table.visits.resize(n, 0);
+  // order[i] 为新编号 i 对应的旧状态，访问次数相同时保持原来的顺序
+  std::vector<int> order(n);
+  for (size_t i = 0; i < n; ++i) {
+    order[i] = static_cast<int>(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&table](int a, int b) {
+    if (a == DFA_ENTRY_STATE_ID || b == DFA_ENTRY_STATE_ID)
+      return a == DFA_ENTRY_STATE_ID && b != DFA_ENTRY_STATE_ID;
+    return table.visits[a] > table.visits[b];
+  });
+  std::vector<int> renumbered(n);
+  for (size_t i = 0; i < n; ++i) {
+    renumbered[order[i]] = static_cast<int>(i);
+  }
+  std::vector<std::array<int, 256>> transition(n);
+  std::vector<int> accept_states(n);
+  std::vector<uint64_t> visits(n);
+  for (size_t i = 0; i < n; ++i) {
+    const auto &row = table.transition[order[i]];
+    for (size_t c = 0; c < 256; ++c) {
+      transition[i][c] = row[c] < 0 ? -1 : renumbered[row[c]];
+    }
+    accept_states[i] = table.accept_states[order[i]];
+    visits[i] = table.visits[order[i]];
+  }
+  table.transition = move(transition);
+  table.accept_states = move(accept_states);
+  table.visits = move(visits);
+  if (!table.stride.empty())
+    BuildStride(table);
+}
+
+void SeuLex::RenumberStates() {
+  for (auto &table : conditions_) {
+    Renumber(table);
+  }
+}
+
+void SeuLex::SaveTables(std::ostream &os) const {
+  // 文本格式：每个条件依次为状态数、每行 128 列的转移、接受状态、关键字（规则 长度 字节）
+  os << "sly-lex-tables 1\n" << conditions_.size() << "\n";
+  for (const auto &table : conditions_) {
+    os << table.transition.size() << "\n";
+    for (const auto &row : table.transition) {
+      for (size_t c = 0; c < 128; ++c) {
+        os << row[c] << (c + 1 < 128 ? " " : "\n");
+      }
+    }
+    for (size_t s = 0; s < table.accept_states.size(); ++s) {
+      os << table.accept_states[s] << (s + 1 < table.accept_states.size() ? " " : "\n");
+    }
+    auto keywords = table.keywords.GetKeywords();
+    os << keywords.size() << "\n";
+    for (const auto &[text, rule] : keywords) {
+      os << rule << " " << text.size() << " " << text << "\n";
+    }
+  }
+}
+
+void SeuLex::LoadTables(std::istream &is) {
+  std::string magic;
+  int version = 0;
+  size_t condition_count = 0;
+  is >> magic >> version >> condition_count;
+  if (!is || magic != "sly-lex-tables" || version != 1)
+    throw runtime_error("Invalid lexer table file.");
+  std::vector<ScanTable> loaded;
+  conditions_.swap(loaded);
+  try {
+    for (size_t k = 0; k < condition_count; ++k) {
+      size_t n = 0;
+      is >> n;
+      std::vector<std::vector<int>> transition(n, std::vector<int>(128));
+      std::vector<int> accept_states(n);
+      for (auto &row : transition) {
+        for (auto &next : row) {
+          is >> next;
+          if (next < -1 || next >= static_cast<int>(n))
+            throw runtime_error("Invalid lexer table file.");
+        }
+      }
+      for (auto &rule : accept_states) {
+        is >> rule;
+        if (rule < -1 || rule >= static_cast<int>(tokens_.size()))
+          throw runtime_error("Invalid lexer table file.");
+      }
+      size_t keyword_count = 0;
+      is >> keyword_count;
+      std::vector<std::pair<std::string, int>> keywords(keyword_count);
+      std::unordered_set<std::string> keyword_texts;
+      for (auto &[text, rule] : keywords) {
+        size_t length = 0;
+        is >> rule >> length;
+        is.get(); // 分隔的空格
+        text.resize(length);
+        is.read(text.data(), static_cast<std::streamsize>(length));
+        if (!is || rule < 0 || rule >= static_cast<int>(tokens_.size()) ||
+            text.empty() || !keyword_texts.insert(text).second)
+          throw runtime_error("Invalid lexer table file.");
+      }
+      if (!is)
+        throw runtime_error("Invalid lexer table file.");
+      AddCondition(transition, move(accept_states), KeywordTable(keywords));
+    }
+  } catch (...) {
+    conditions_.swap(loaded);
+    throw;
+  }
+  condition_ = 0;
+}
 
+void SeuLex::SetScanLoop(ScanLoop loop) {
+  scan_loop_ = loop;
+  if (loop != ScanLoop::kStride2)
+    return;
+  for (auto &table : conditions_) {
+    if (table.class_count == 0)
+      BuildStride(table);
+  }
+}
+
+void SeuLex::Begin(int condition) {
+  if (condition < 0 || static_cast<size_t>(condition) >= conditions_.size()) {
+    spdlog::error("BEGIN: start condition {} is not defined.", condition);
+    throw runtime_error("Undefined start condition.");
+  }
+  condition_ = condition;
+}
+
+int SeuLex::GetCondition() const { return condition_; }
+
+void SeuLex::Open(const std::string &path) {
+  file_ = std::make_unique<MappedFile>(path);
+  SetInput(file_->View());
+}
+
+void SeuLex::SetInput(std::string_view input) {
+  stream_.reset();
+  begin_ = cursor_ = token_ = input.data();
+  end_ = input.data() + input.size();
+  base_ = 0;
+  max_span_ = 0;
+  lexemes_.clear();
+  lines_.Clear();
+}
+
+void SeuLex::SetIn(std::istream *in, size_t capacity) {
+  yyin = in;
+  file_.reset();
+  stream_ = std::make_unique<InputBuffer>(yyin, capacity);
+  begin_ = cursor_ = token_ = end_ = stream_->Data();
+  base_ = 0;
+  max_span_ = 0;
+  lexemes_.clear();
+  lines_.Clear();
+}
+
+bool SeuLex::Refill(const char *&token_start, const char *&p) {
+  if (stream_ == nullptr)
+    return false;
+  // 即将丢弃的部分先建立行首索引
+  IndexUpTo(base_ + (token_start - begin_));
+  auto keep = static_cast<size_t>(token_start - begin_);
+  auto pos = static_cast<size_t>(p - token_start);
+  size_t count = stream_->Refill(keep);
+  base_ += keep;
+  begin_ = token_start = stream_->Data();
+  end_ = begin_ + stream_->Size();
+  p = begin_ + pos;
+  return count > 0;
+}
+
+namespace {
+
+/**
+ * 以下扫描循环从 state、p 出发转移，直到遇到无法转移的字节（哨兵 '\0' 恒无法转移），
+ * 并记录最后一次经过的接受状态：rule 为规则编号，length 为相对 start 的长度。
+ * 能够转移的字节一定不是哨兵，所以读它之后的一个字节不会越界。
+ */
+template <typename Transition>
+inline void RunByte(const Transition &transition, const std::vector<int> &accept_states,
+                    int &state, const char *&p, const char *start,
+                    int &rule, size_t &length) {
+  while (true) {
+    int next = transition[state][static_cast<unsigned char>(*p)];
+    if (next < 0)
+      return;
+    state = next;
+    ++p;
+    if (accept_states[state] >= 0) {
+      rule = accept_states[state];
+      length = p - start;
+    }
+  }
+}
+
+template <typename Transition>
+inline void RunProfiled(const Transition &transition, const std::vector<int> &accept_states,
+                        std::vector<uint64_t> &visits, int &state, const char *&p,
+                        const char *start, int &rule, size_t &length) {
+  while (true) {
+    ++visits[state];
+    int next = transition[state][static_cast<unsigned char>(*p)];
+    if (next < 0)
+      return;
+    state = next;
+    ++p;
+    if (accept_states[state] >= 0) {
+      rule = accept_states[state];
+      length = p - start;
+    }
+  }
+}
+
+template <typename Transition>
+inline void RunUnrolled(const Transition &transition, const std::vector<int> &accept_states,
+                        int &state, const char *&p, const char *start,
+                        int &rule, size_t &length) {
+  int s[4];
+  while (true) {
+    auto q = reinterpret_cast<const unsigned char *>(p);
+    int n = 4;
+    if ((s[0] = transition[state][q[0]]) < 0)
+      return;
+    if ((s[1] = transition[s[0]][q[1]]) < 0)
+      n = 1;
+    else if ((s[2] = transition[s[1]][q[2]]) < 0)
+      n = 2;
+    else if ((s[3] = transition[s[2]][q[3]]) < 0)
+      n = 3;
+    p += n;
+    state = s[n - 1];
+    // 整块 4 个字节只判断一次：各状态都不接受时 accept_states 均为 -1
+    if (n == 4 && (accept_states[s[0]] & accept_states[s[1]] &
+                   accept_states[s[2]] & accept_states[s[3]]) < 0)
+      continue;
+    for (int i = n - 1; i >= 0; --i) {
+      if (accept_states[s[i]] >= 0) {
+        rule = accept_states[s[i]];
+        length = (p - start) - (n - 1 - i);
+        break;
+      }
+    }
+    if (n < 4)
+      return;
+  }
+}
+
+template <typename Transition, typename Stride>
+inline void RunStride(const Transition &transition, const std::vector<int> &accept_states,
+                      const std::array<uint8_t, 256> &classes, size_t class_count,
+                      const Stride &stride, int &state, const char *&p,
+                      const char *start, int &rule, size_t &length) {
+  size_t row = state * class_count * class_count;
+  while (true) {
+    auto c0 = static_cast<unsigned char>(p[0]);
+    if (c0 == 0)
+      return;
+    const auto &entry = stride[row + classes[c0] * class_count +
+                               classes[static_cast<unsigned char>(p[1])]];
+    if (entry.next >= 0) {
+      if (entry.middle_rule >= 0) {
+        rule = entry.middle_rule;
+        length = p + 1 - start;
+      }
+      state = entry.next;
+      row = entry.next_row;
+      p += 2;
+    } else {
+      // 第二个字节无法转移（包括读到哨兵），只走一步
+      int next = transition[state][c0];
+      if (next < 0)
+        return;
+      state = next;
+      row = state * class_count * class_count;
+      ++p;
+    }
+    if (accept_states[state] >= 0) {
+      rule = accept_states[state];
+      length = p - start;
+    }
+  }
+}
+
+}
+
+int SeuLex::Scan(size_t &offset, size_t &length) {
+  auto &table = conditions_[condition_];
+  const char *start = cursor_;
+  const char *p = start;
+  int state = DFA_ENTRY_STATE_ID;
+  // 最长匹配：记录最后一次经过的接受状态，失败时回退到该位置
+  int rule = -1;
+  length = 0;
+  while (true) {
+    if (profiling_)
+      RunProfiled(table.transition, table.accept_states, table.visits,
+                  state, p, start, rule, length);
+    else if (scan_loop_ == ScanLoop::kStride2 && !table.stride.empty())
+      RunStride(table.transition, table.accept_states, table.classes,
+                table.class_count, table.stride, state, p, start, rule, length);
+    else if (scan_loop_ == ScanLoop::kByte)
+      RunByte(table.transition, table.accept_states, state, p, start, rule, length);
+    else
+      RunUnrolled(table.transition, table.accept_states, state, p, start, rule, length);
+    // 只有读到哨兵时才需要判断是否到达缓冲区末尾
+    if (p != end_ || !Refill(start, p))
+      break;
+  }
+  token_ = start;
+  offset = base_ + static_cast<size_t>(start - begin_);
+  max_span_ = std::max(max_span_, static_cast<size_t>(p - start));
+  if (p == start && p == end_)
+    return -1;
+
+  if (rule < 0)
+    ReportError(start, p);
+  if (!table.keywords.Empty())
+    rule = table.keywords.Reclassify(start, length, rule);
+  cursor_ = start + length;
+  return rule;
+}
+
+int SeuLex::MatchAt(const char *start, size_t &length, const char *&stop) const {
+  const auto &table = conditions_[condition_];
+  const char *p = start;
+  int state = DFA_ENTRY_STATE_ID;
+  int rule = -1;
+  length = 0;
+  RunByte(table.transition, table.accept_states, state, p, start, rule, length);
+  stop = p;
+  if (rule >= 0 && !table.keywords.Empty())
+    rule = table.keywords.Reclassify(start, length, rule);
+  return rule;
+}
+
+void SeuLex::ReportError(const char *start, const char *p) {
+  auto offset = base_ + static_cast<size_t>(p - begin_);
+  auto [row, col] = Locate(offset);
+  char c = p == end_ ? '\0' : *p;
+  spdlog::error("{}:{}: \033[31mlexical error:\033[0m", __FILE__, __LINE__);
+  spdlog::error("caught invalid element '\033[33m{}\033[0m' (ascii={}) at line {} column {}",
+                c, static_cast<int>(c), row, col);
+  spdlog::error("current_buffer=\"\033[33m{}\033[0m\"",
+                sly::utils::escape(std::string(start, p)));
+  throw runtime_error("Lexical error.");
+}
+
+Lexeme SeuLex::Lex() {
+  Lexeme lexeme{};
+  lexeme.rule = Scan(lexeme.offset, lexeme.length);
+  return lexeme;
+}
+
+size_t SeuLex::LexBatch(const TokenBatch &batch) {
+  size_t count = 0;
+  size_t offset, length;
+  while (count < batch.capacity) {
+    int rule = Scan(offset, length);
+    if (rule < 0)
+      break;
+    batch.rules[count] = rule;
+    batch.offsets[count] = offset;
+    batch.lengths[count] = static_cast<uint32_t>(length);
+    if (batch.locations != nullptr)
+      batch.locations[count] = Locate(offset);
+    ++count;
+  }
+  return count;
+}
+
+void SeuLex::Process() {
+  lexemes_.clear();
+  for (auto lexeme = Lex(); lexeme.rule >= 0; lexeme = Lex()) {
+    lexemes_.push_back(lexeme);
+  }
+}
+
+void SeuLex::ScanChunk(const char *first, const char *last,
+                       std::vector<Lexeme> &result, size_t &max_span) const {
+  const char *p = first;
+  size_t length;
+  const char *stop;
+  while (p < last) {
+    int rule = MatchAt(p, length, stop);
+    max_span = std::max(max_span, static_cast<size_t>(stop - p));
+    if (rule < 0)
+      break; // 推测的起点可能并不是词法单元的起点，剩余部分留给顺序扫描
+    result.push_back({rule, base_ + static_cast<size_t>(p - begin_), length});
+    p += length;
+  }
+}
+
+void SeuLex::ParallelProcess(size_t thread_count) {
+  auto size = static_cast<size_t>(end_ - cursor_);
+  if (stream_ != nullptr || thread_count <= 1 ||
+      size < 2 * PARALLEL_LEX_MIN_CHUNK) {
+    Process();
+    return;
+  }
+  size_t chunk_count = std::min(thread_count, size / PARALLEL_LEX_MIN_CHUNK);
+
+  // 分块：每块从名义位置之后的第一个换行后开始，这样的位置大概率是词法单元的起点
+  std::vector<const char *> bounds(chunk_count + 1);
+  bounds[0] = cursor_;
+  bounds[chunk_count] = end_;
+  for (size_t k = 1; k < chunk_count; ++k) {
+    const char *p = std::max(cursor_ + size * k / chunk_count, bounds[k - 1]);
+    auto nl = static_cast<const char *>(std::memchr(p, '\n', end_ - p));
+    bounds[k] = nl == nullptr ? end_ : nl + 1;
+  }
+
+  // 第 0 块从真实起点开始，其余各块从推测的起点开始
+  std::vector<std::vector<Lexeme>> chunks(chunk_count);
+  std::vector<size_t> spans(chunk_count, 0);
+  std::vector<std::thread> workers;
+  for (size_t k = 1; k < chunk_count; ++k) {
+    workers.emplace_back([this, &bounds, &chunks, &spans, k] {
+      ScanChunk(bounds[k], bounds[k + 1], chunks[k], spans[k]);
+    });
+  }
+  ScanChunk(bounds[0], bounds[1], chunks[0], spans[0]);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  max_span_ = std::max(max_span_, *std::max_element(spans.begin(), spans.end()));
+
+  // 拼接：从同一位置开始的扫描结果相同，所以顺序扫描一旦到达某块中某个词法单元的起点，
+  // 该块之后的结果都可以直接采用；否则顺序扫描该块
+  lexemes_ = std::move(chunks[0]);
+  const char *p = lexemes_.empty()
+                      ? cursor_
+                      : begin_ + (lexemes_.back().offset - base_) +
+                            lexemes_.back().length;
+  size_t length;
+  const char *stop;
+  for (size_t k = 1; k <= chunk_count; ++k) {
+    const char *last = k < chunk_count ? bounds[k + 1] : end_;
+    const auto *chunk = k < chunk_count ? &chunks[k] : nullptr;
+    size_t j = 0;
+    while (p < last) {
+      if (chunk != nullptr) {
+        auto offset = base_ + static_cast<size_t>(p - begin_);
+        while (j < chunk->size() && (*chunk)[j].offset < offset)
+          ++j;
+        if (j < chunk->size() && (*chunk)[j].offset == offset) {
+          lexemes_.insert(lexemes_.end(), chunk->begin() + j, chunk->end());
+          p = begin_ + (lexemes_.back().offset - base_) + lexemes_.back().length;
+          chunk = nullptr;
+          continue;
+        }
+      }
+      int rule = MatchAt(p, length, stop);
+      max_span_ = std::max(max_span_, static_cast<size_t>(stop - p));
+      if (rule < 0)
+        ReportError(p, stop);
+      lexemes_.push_back({rule, base_ + static_cast<size_t>(p - begin_), length});
+      p += length;
+    }
+  }
+  if (!lexemes_.empty())
+    token_ = begin_ + (lexemes_.back().offset - base_);
+  cursor_ = p;
+}
+
+LexemeDiff SeuLex::Relex(size_t offset, size_t deleted, std::string_view text) {
+  if (stream_ != nullptr)
+    throw runtime_error("Relex is not available for streamed input.");
+  if (begin_ != edit_buffer_.data()) {
+    // 第一次编辑：复制一份可修改的输入
+    edit_buffer_.assign(begin_, end_);
+    file_.reset();
+  }
+  if (offset + deleted > edit_buffer_.size())
+    throw runtime_error("Edit is out of range.");
+  edit_buffer_.replace(offset, deleted, text);
+  begin_ = token_ = edit_buffer_.data();
+  end_ = cursor_ = begin_ + edit_buffer_.size();
+  lines_.Truncate(offset);
+
+  const auto &old = lexemes_;
+  auto shift = static_cast<ptrdiff_t>(text.size()) - static_cast<ptrdiff_t>(deleted);
+  size_t edit_end = offset + text.size();
+
+  // 自动机在 stop 处停下，说明它读过 [start, stop] 的字符；stop < offset 的词法单元不受影响。
+  // 自动机走过的长度不超过 max_span_，因此只需检查起点不早于 offset - max_span_ 的词法单元
+  auto q = static_cast<size_t>(
+      std::lower_bound(old.begin(), old.end(), offset,
+                       [](const Lexeme &l, size_t v) { return l.offset < v; }) -
+      old.begin());
+  size_t first = q;
+  size_t length;
+  const char *stop;
+  for (size_t j = q; j > 0; --j) {
+    const auto &lexeme = old[j - 1];
+    if (lexeme.offset + max_span_ < offset)
+      break;
+    MatchAt(begin_ + lexeme.offset, length, stop);
+    if (static_cast<size_t>(stop - begin_) >= offset)
+      first = j - 1;
+  }
+
+  LexemeDiff diff{first, 0, {}, shift};
+  const char *p = first < old.size() ? begin_ + old[first].offset
+                  : old.empty()      ? begin_
+                                     : begin_ + old.back().offset + old.back().length;
+  // 重新扫描，直到编辑之后某个位置与旧的词法单元起点对齐
+  size_t m = first;
+  while (true) {
+    auto pos = static_cast<size_t>(p - begin_);
+    if (pos >= edit_end) {
+      auto old_pos = static_cast<size_t>(static_cast<ptrdiff_t>(pos) - shift);
+      while (m < old.size() && old[m].offset < old_pos)
+        ++m;
+      if (m < old.size() && old[m].offset == old_pos)
+        break;
+    }
+    if (p == end_) {
+      m = old.size();
+      break;
+    }
+    int rule = MatchAt(p, length, stop);
+    max_span_ = std::max(max_span_, static_cast<size_t>(stop - p));
+    if (rule < 0)
+      ReportError(p, stop);
+    diff.inserted.push_back({rule, pos, length});
+    p += length;
+  }
+  diff.removed = m - first;
+
+  // 更新 lexemes_：替换受影响的部分，其后的偏移量整体移动
+  for (size_t i = m; i < lexemes_.size(); ++i) {
+    lexemes_[i].offset = static_cast<size_t>(static_cast<ptrdiff_t>(lexemes_[i].offset) + shift);
+  }
+  lexemes_.erase(lexemes_.begin() + first, lexemes_.begin() + m);
+  lexemes_.insert(lexemes_.begin() + first, diff.inserted.begin(), diff.inserted.end());
+  return diff;
+}
+
+std::vector<std::vector<Lexeme>>
+SeuLex::LexStreams(const std::vector<std::string_view> &inputs) const {
+  const auto &table = conditions_[condition_];
+  const auto &transition = table.transition;
+  const auto &accept_states = table.accept_states;
+  std::vector<std::vector<Lexeme>> result(inputs.size());
+
+  // 各通道的状态按数组分开存放（结构体数组的转置），start 为当前词法单元的起点
+  constexpr size_t K = INTERLEAVED_LEX_STREAMS;
+  std::array<const char *, K> begin{}, start{}, p{}, end{};
+  std::array<int, K> state{}, rule{};
+  std::array<size_t, K> length{}, input{};
+  // 空闲的通道停在一个空串上，每步都无法转移，由 idle 掩码跳过
+  static const char empty[1] = {'\0'};
+  unsigned idle = 0;
+  size_t next_input = 0;
+  auto assign = [&](size_t k) {
+    while (next_input < inputs.size() && inputs[next_input].empty())
+      ++next_input;
+    state[k] = DFA_ENTRY_STATE_ID;
+    rule[k] = -1;
+    length[k] = 0;
+    if (next_input == inputs.size()) {
+      begin[k] = start[k] = p[k] = end[k] = empty;
+      idle |= 1u << k;
+      return;
+    }
+    const auto &in = inputs[next_input];
+    begin[k] = start[k] = p[k] = in.data();
+    end[k] = in.data() + in.size();
+    input[k] = next_input++;
+  };
+  for (size_t k = 0; k < K; ++k) {
+    assign(k);
+  }
+
+  constexpr unsigned all = (1u << K) - 1;
+  while (idle != all) {
+    // 所有通道同时走一步，不分支：无法转移的通道保持原状，记入 dead
+    unsigned dead = 0;
+    for (size_t k = 0; k < K; ++k) {
+      int next = transition[state[k]][static_cast<unsigned char>(*p[k])];
+      bool alive = next >= 0;
+      state[k] = alive ? next : state[k];
+      p[k] += alive;
+      // 与单个输入的扫描一样只在转移之后记录接受状态：入口状态可以接受空串时，
+      // 停在入口的通道不会记录长度为 0 的词法单元，而是报告词法错误
+      bool accepted = alive && accept_states[state[k]] >= 0;
+      rule[k] = accepted ? accept_states[state[k]] : rule[k];
+      length[k] = accepted ? static_cast<size_t>(p[k] - start[k]) : length[k];
+      dead |= static_cast<unsigned>(!alive) << k;
+    }
+    dead &= ~idle;
+    // 结束的词法单元
+    for (; dead != 0; dead &= dead - 1) {
+      size_t k = __builtin_ctz(dead);
+      if (rule[k] < 0) {
+        auto offset = static_cast<size_t>(p[k] - begin[k]);
+        spdlog::error("{}:{}: \033[31mlexical error:\033[0m", __FILE__, __LINE__);
+        spdlog::error("caught invalid element (ascii={}) in input {} at offset {}",
+                      static_cast<int>(*p[k]), input[k], offset);
+        throw runtime_error("Lexical error.");
+      }
+      int matched = table.keywords.Empty()
+                        ? rule[k]
+                        : table.keywords.Reclassify(start[k], length[k], rule[k]);
+      result[input[k]].push_back(
+          {matched, static_cast<size_t>(start[k] - begin[k]), length[k]});
+      start[k] += length[k];
+      p[k] = start[k];
+      state[k] = DFA_ENTRY_STATE_ID;
+      rule[k] = -1;
+      if (start[k] == end[k])
+        assign(k);
+    }
+  }
+  return result;
+}
+
+TextView SeuLex::Text(const Lexeme &lexeme) const {
+  return {begin_ + (lexeme.offset - base_), lexeme.length};
+}
+
+const SeuLex::Token &SeuLex::GetToken(const Lexeme &lexeme) const {
+  if (lexeme.rule < 0)
+    return end_token_;
+  return tokens_[lexeme.rule];
+}
+
+const std::vector<Lexeme> &SeuLex::GetLexemes() const { return lexemes_; }
+
+void SeuLex::IndexUpTo(size_t offset) {
+  if (offset <= lines_.Indexed())
+    return;
+  // 一次索引缓冲区中已有的全部内容
+  const char *p = begin_ + (lines_.Indexed() - base_);
+  lines_.Extend(p, end_ - p);
+}
+
+core::type::SourceLocation SeuLex::Locate(size_t offset) {
+  IndexUpTo(offset);
+  return lines_.Locate(offset);
+}
+
+char SeuLex::Input() {
+  if (cursor_ == end_ && !Refill(token_, cursor_))
+    return 0; // file end
+  return *cursor_++;
+}
+
+void SeuLex::Unput(char c) {
+  if (cursor_ == begin_) {
+    // 流式输入时，已丢弃的字符无法退回
+    spdlog::error("unput: no character read before '{}' in the buffer.", c);
+    throw runtime_error("Cannot unput before the start of the buffer.");
+  }
+  if (cursor_[-1] != c) {
+    auto at = static_cast<size_t>(cursor_ - begin_) - 1;
+    if (stream_ != nullptr) {
+      stream_->Data()[at] = c;
+    } else {
+      if (begin_ != edit_buffer_.data()) {
+        // 第一次写入：复制一份可修改的输入。映射的文件保留到下一次设置输入，
+        // 之前 Text() 返回的视图仍然有效
+        auto cursor = cursor_ - begin_, token = token_ - begin_;
+        edit_buffer_.assign(begin_, end_);
+        begin_ = edit_buffer_.data();
+        end_ = begin_ + edit_buffer_.size();
+        cursor_ = begin_ + cursor;
+        token_ = begin_ + token;
+      }
+      edit_buffer_[at] = c;
+    }
+  }
+  --cursor_;
+  // 退回到词法单元起点之前时，流式输入补充数据也要保留这些字符
+  token_ = std::min(token_, cursor_);
+}
+
+void SeuLex::SetOut(std::ostream *out) { yyout = out; }
+
+void SeuLex::Echo(const Lexeme &lexeme) const {
+  if (yyout != nullptr)
+    *yyout << Text(lexeme);
+}
 
 }
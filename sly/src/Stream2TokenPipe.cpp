@@ -1,6 +1,8 @@
 #include "sly/Token.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <cassert>
+#include <sly/InputBuffer.h>
 #include <sly/Stream2TokenPipe.h>
 #include <sly/utils.h>
 #include <stdexcept>
@@ -21,95 +23,140 @@ Stream2TokenPipe::Stream2TokenPipe(std::vector<std::vector<int>> working_table,
   history_count_=0;
 }
 
-char Stream2TokenPipe::input(std::istream& is) {
+bool Stream2TokenPipe::Peek(std::istream &is, size_t i, char &c) {
+  if (i < window_.size()) {
+    c = window_[i];
+    return true;
+  }
   if (!(is.good() && !is.eof() && !is.fail())) {
-    return 0; // file end
+    return false;
+  }
+  int ch = is.get();
+  if (ch == std::char_traits<char>::eof()) {
+    return false;
+  }
+  c = static_cast<char>(ch);
+  SLY_LOG_TRACE("Caught ascii={} char={} From stream.", static_cast<int>(c), c);
+  window_.push_back(c);
+  return true;
+}
+
+void Stream2TokenPipe::Advance(char c) {
+  // 与 LineIndex 相同：'\n' 开始新的一行（"\r\n" 也只算一次），'\r' 按普通字符计列，
+  // 制表符跳到下一个 8 的倍数加 1 列
+  if (c == '\n') {
+    col_ = 1;
+    row_ ++;
+  } else if (c == '\t') {
+    col_ += 8 - ((col_ - 1) % 8);
   } else {
-    char c = is.get();
-    spdlog::debug(
-      "Caught ascii={} char={} From stream.", 
-      static_cast<int>(c), c
-    );
-    row_prev_ = row_;
-    col_prev_ = col_;
-    if (c == '\n') {
-      col_ = 1;
-    } else if (c == '\r') {
-      col_ = 1;
-      row_ ++;
-    } else if (c == '\t') {
-      col_ += (8 - ((col_ - 1) % 8)) + 1;
-    } else {
-      col_ ++;
+    col_ ++;
+  }
+}
+
+void Stream2TokenPipe::Advance(std::string_view text) {
+  // 只有最后一个换行之后的部分影响列号
+  auto last_break = text.find_last_of('\n');
+  if (last_break != std::string_view::npos) {
+    row_ += std::count(text.begin(), text.begin() + last_break + 1, '\n');
+    col_ = 1;
+    text.remove_prefix(last_break + 1);
+  }
+  if (text.find('\t') == std::string_view::npos) {
+    col_ += static_cast<int>(text.size());
+  } else {
+    for (char c : text) {
+      Advance(c);
     }
-    return c;
   }
 }
 
-void Stream2TokenPipe::unput(std::istream &is, char c) {
-  is.putback(c);
+char Stream2TokenPipe::input(std::istream& is) {
+  char c;
+  if (!Peek(is, pos_, c)) {
+    return 0; // file end
+  }
+  ++pos_;
+  row_prev_ = row_;
+  col_prev_ = col_;
+  Advance(c);
+  return c;
+}
+
+void Stream2TokenPipe::unput(char c) {
+  if (pos_ > 0 && window_[pos_ - 1] == c) {
+    --pos_;
+  } else {
+    window_.insert(pos_, 1, c);
+  }
   row_ = row_prev_;
   col_ = col_prev_;
 }
 
 core::type::Token Stream2TokenPipe::Defer(std::istream &is) {
   int current_state = 0;
-  char c;
+  char c = 0;
   buffer_.clear();
   token_begin_row_ = row_;
   token_begin_col_ = col_;
 
-  if (!(is.good() && !is.eof() && !is.fail())) {
-    return end_token_;
-  }
-  while (is.good() && !is.eof() && !is.fail()) {
-    if (history_.size() > 20) {
-      history_ = history_.substr(10);
-    }
-    // c = is.get();
-    c = input(is);
-    spdlog::debug("Caught ascii={} char={} From stream.", static_cast<int>(c),
-                 c);
+  // 最长匹配：记录最后一次经过的接受状态，结束后回退到该位置
+  int return_token_id = -1;
+  size_t last_accept = pos_;
+  size_t i = pos_;
+  bool at_end = true;
+  while (Peek(is, i, c)) {
     // 1. 测试是否是可行的
     if (!(c > static_cast<int8_t>(0) && c <= static_cast<int8_t>(127))) {
-      spdlog::debug("Handling the eof flag.");
-      if (buffer_.length() == 0) {
-        // 如果 buffer 是空的，直接返回 eof 标志
-        return end_token_;
-      } else {
-        // 如果 buffer 不空，则先返回之前的内容，并把 c 放回。
-        unput(is, c);
-        break;
-      }
+      SLY_LOG_TRACE("Handling the eof flag.");
+      break;
     }
     int next_state = table_[current_state][c];
     if (next_state == -1) {
-      // flush buffer and return
-      unput(is, c);
+      at_end = false;
       break;
-    } else {
-      spdlog::debug("Push to buffer.");
-      buffer_.push_back(c);
-      history_.push_back(c);
-      history_count_ ++;
-      current_state = next_state;
+    }
+    current_state = next_state;
+    ++i;
+    if (accept_states_[current_state] >= 0) {
+      return_token_id = accept_states_[current_state];
+      last_accept = i;
     }
   }
-  token_end_row_ = row_;
-  token_end_col_ = col_;
+  if (i == pos_ && at_end) {
+    // 没有读到任何字符，直接返回 eof 标志
+    return end_token_;
+  }
 
-  // 显然当前 buffer 不空
-  int return_token_id = accept_states_[current_state];
   if (return_token_id < 0) {
+    buffer_.assign(window_, pos_, i - pos_);
     spdlog::error("{}:{}: \033[31mlexical error:\033[0m", __FILE__, __LINE__);
     spdlog::error("caught invalid element '\033[33m{}\033[0m' (ascii={}) at line {} column {}", 
                   c, static_cast<int>(c), row_+1, col_+1);
     spdlog::error("current_buffer=\"\033[33m{}\033[0m\"", sly::utils::escape(buffer_));
     spdlog::error("history_=\"\033[33m{}\033[0m\"", sly::utils::escape(history_));
     exit(1);
-  } else {
-    spdlog::info("return: buffer={} corr={}", buffer_, token_list_[return_token_id].ToString());
   }
+
+  buffer_.assign(window_, pos_, last_accept - pos_);
+  Advance(std::string_view(buffer_));
+  history_ += buffer_;
+  history_count_ += buffer_.size();
+  if (history_.size() > 20) {
+    history_ = history_.substr(history_.size() - 10);
+  }
+  pos_ = last_accept;
+  if (pos_ == window_.size()) {
+    window_.clear();
+    pos_ = 0;
+  } else if (pos_ >= LEX_BUFFER_SIZE) {
+    window_.erase(0, pos_);
+    pos_ = 0;
+  }
+  token_end_row_ = row_;
+  token_end_col_ = col_;
+
+  SLY_LOG_DEBUG("return: buffer={} corr={}", buffer_, token_list_[return_token_id].ToString());
   return token_list_[return_token_id];
 }
 
@@ -55,6 +55,7 @@ bool ParsingTable::PutAction(IdType lhs, const Token &tok,
   }
   action_table_[lhs].insert({tok, {action}});
 
+#if SLY_ACTIVE_LOG_LEVEL <= SLY_LOG_LEVEL_DEBUG
   string acts;
   if (action.action == AutomataAction::kEmpty)
     acts = "?";
@@ -66,8 +67,9 @@ bool ParsingTable::PutAction(IdType lhs, const Token &tok,
     acts = "Acc";
   else
     acts = "Err";
-  spdlog::debug("Putting ACTION: StateID: {} Token: {}\t Action: {} {}", lhs,
+  SLY_LOG_DEBUG("Putting ACTION: StateID: {} Token: {}\t Action: {} {}", lhs,
                 tok.ToString(), acts, action.id);
+#endif
 
   return true;
 }
@@ -81,7 +83,7 @@ bool ParsingTable::PutGoto(IdType lhs, const Token &tok, IdType rhs) {
   if (f != goto_table_[lhs].end())
     f->second.push_back(rhs);
   goto_table_[lhs].insert({tok, {rhs}});
-  spdlog::debug("Putting  GOTO : From: {} To: {} \t Token{}", lhs, rhs,
+  SLY_LOG_DEBUG("Putting  GOTO : From: {} To: {} \t Token{}", lhs, rhs,
                 utils::ToString{}(tok));
 
   return true;
@@ -597,7 +599,6 @@ void ParsingTable::PrintGeneratorCodeOpti(ostream &os) const {
     os << "  action_table_, goto_table_, productions_, " << std::endl;
     os << "  entry_token_, augmented_token_, epsilon_token_" << std::endl;
     os << ");" << std::endl;
-    os << "table.SetAllToError(__tokens_in_use);";
     os << "}}" << endl;
     defer_table_function_impl = os.str();
   }
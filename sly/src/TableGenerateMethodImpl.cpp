@@ -4,475 +4,652 @@
 
 #include "spdlog/spdlog.h"
 #include <algorithm>
+#include <atomic>
+#include <climits>
 #include <iostream>
 #include <iterator>
+#include <map>
+#include <mutex>
 #include <sly/TableGenerateMethodImpl.h>
 #include <sly/utils.h>
 #include <sstream>
+#include <thread>
 
 namespace sly::core::grammar {
 
 void Lr1::Defer(const ContextFreeGrammar &cfg) {
   p_grammar = &cfg;
-  GenFirst();
-  GenFollow();
+  grammar_.emplace(cfg);
+  GenStates();
   GenItemGo();
   GenTable();
 }
 
-optional<unordered_set<LRItem, LRItem::Hash>>
-Lr1::Lr1GotoFunc(const LRItemSet &lrs, const Token &tok) const {
-  LRItemSet retval;
-  for (const auto &lri : lrs) {
-    auto deferred = lri.Defer(tok);
-    if (deferred.has_value())
-      retval.insert(deferred.value());
+size_t Lr1::HashOf(const vector<Item> &kernel,
+                   const vector<TerminalSet> &look_ahead) {
+  size_t hv = 0;
+  for (size_t i = 0; i < kernel.size(); ++i) {
+    hv = hv * 1000003 ^ (kernel[i].first << 16 ^ kernel[i].second);
+    hv = hv * 1000003 ^ TerminalSet::Hash{}(look_ahead[i]);
   }
-  if (retval.empty())
-    return optional<LRItemSet>{};
-  else
-    return make_optional(Lr1Closure(retval));
+  return hv;
 }
 
-void Lr1::GenFirst() {
-  FUNC_START_INFO;
-  bool changed = true;
-  first_set_.clear();
-  for (const auto &tok : p_grammar->GetNonTerminators()) {
-    // First [ Non-Term ] init as Empty
-    first_set_.insert({tok, {}});
+void Lr1::Enqueue(int state) {
+  if (!is_pending_[state]) {
+    is_pending_[state] = true;
+    pending_.push_back(state);
   }
-  for (const auto &tok : p_grammar->GetTerminators()) {
-    // First [ Term ] === Term
-    first_set_.insert({tok, {tok}});
+}
+
+int Lr1::AddState(vector<Item> kernel, vector<TerminalSet> look_ahead) {
+  int s = static_cast<int>(states_.size());
+  states_.push_back(State{std::move(kernel), std::move(look_ahead), {}});
+  is_pending_.push_back(false);
+  Enqueue(s);
+  return s;
+}
+
+int Lr1::FindOrMerge(vector<Item> kernel, vector<TerminalSet> look_ahead,
+                     size_t hash) {
+  auto &candidates = kernel_id_[hash];
+  for (int s : candidates) {
+    if (states_[s].kernel == kernel && states_[s].look_ahead == look_ahead)
+      return s;
   }
-  int iter = 0;
-  while (changed) {
-    changed = false;
-    for (auto &prod : p_grammar->GetProductions()) {
-      // ForEach Production, Update the first set of `lhs`
-      auto &tokens = prod.GetTokens();
-      auto &lhs = tokens.front();
-      auto first_updated = GetFirst(tokens.cbegin() + 1, tokens.cend());
-      auto &current = first_set_[lhs];
-      for (auto &v : first_updated) {
-        if (current.find(v) == current.end()) {
-          current.insert(v);
-          changed = true;
-        }
-      }
-    }
+  int s = AddState(std::move(kernel), std::move(look_ahead));
+  candidates.push_back(s);
+  return s;
+}
+
+vector<Lr1::Successor> Lr1::GetSuccessors(int i) const {
+  const auto &g = grammar_.value();
+  // 按圆点后的符号分组，核心项目按项目升序
+  map<int, vector<pair<Item, TerminalSet>>> next;
+  for (auto &[item, la] :
+       g.Lr1Closure(states_[i].kernel, states_[i].look_ahead)) {
+    auto [p, dot] = item;
+    if (dot < g.GetRhs(p).size())
+      next[g.GetRhs(p)[dot]].emplace_back(Item{p, dot + 1}, std::move(la));
   }
-#ifndef NDEBUG
-  for (const auto &[k, v] : first_set_) {
-    ostringstream ss;
-    ss << "First [" << k << "]: ";
-    copy(v.begin(), v.end(), ostream_iterator<decltype(v)::value_type>(ss));
-    spdlog::debug("{}", ss.str());
+  vector<Successor> successors;
+  for (auto &[sym, items] : next) {
+    sort(items.begin(), items.end(),
+         [](const auto &a, const auto &b) { return a.first < b.first; });
+    Successor succ{sym, {}, {}, 0};
+    for (auto &[item, la] : items) {
+      succ.kernel.push_back(item);
+      succ.look_ahead.push_back(std::move(la));
+    }
+    succ.hash = HashOf(succ.kernel, succ.look_ahead);
+    successors.push_back(std::move(succ));
   }
-#endif
-  FUNC_END_INFO;
+  return successors;
 }
 
-void Lr1::GenFollow() {
+void Lr1::GenStates() {
   FUNC_START_INFO;
-  follow_set_.clear();
-  if (first_set_.empty())
-    throw runtime_error("Calculate first set first!");
-  for (auto &tok : p_grammar->GetNonTerminators()) {
-    follow_set_.insert({tok, {}});
-  }
-
-  follow_set_[p_grammar->GetAugmentedToken()].insert(
-      p_grammar->GetEndingToken());
-
-  bool changed = true;
-  while (changed) {
-    changed = false;
-    for (auto &[tok, curr_follow] : follow_set_) {
-      for (const auto &prod : p_grammar->GetProductions()) {
-        const auto &follow_lhs = follow_set_[prod.GetTokens().front()];
-        for (auto it = prod.GetTokens().cbegin() + 1;
-             it != prod.GetTokens().cend(); it++) {
-          if (*it == tok) {
-            auto rest_first = GetFirst(it + 1, prod.GetTokens().cend());
-            if (rest_first.find(p_grammar->GetEpsilonToken()) !=
-                rest_first.end()) {
-              rest_first.erase(p_grammar->GetEpsilonToken());
-              rest_first.insert(follow_lhs.begin(), follow_lhs.end());
-            }
-            for (auto &t : rest_first) {
-              if (curr_follow.find(t) == curr_follow.end()) {
-                changed = true;
-                curr_follow.insert(t);
-              }
-            }
-          }
-        }
+  const auto &g = grammar_.value();
+  states_.clear();
+  kernel_id_.clear();
+  pending_.clear();
+  is_pending_.clear();
+  TerminalSet ending(g.GetTerminatorCount());
+  ending.Set(g.SymbolOf(p_grammar->GetEndingToken()));
+  vector<Item> start{{0, 0}};
+  vector<TerminalSet> start_la{ending};
+  size_t start_hash = HashOf(start, start_la);
+  FindOrMerge(std::move(start), std::move(start_la), start_hash);
+  while (!pending_.empty()) {
+    vector<int> level;
+    level.swap(pending_);
+    for (int i : level)
+      is_pending_[i] = false;
+    // 1. 并行：求闭包、分组、计算核心的散列值
+    vector<vector<Successor>> successors(level.size());
+    ParallelFor(level.size(),
+                [&](size_t k) { successors[k] = GetSuccessors(level[k]); });
+    // 2. 顺序：按状态、符号的顺序查找或新建目标状态
+    for (size_t k = 0; k < level.size(); ++k) {
+      vector<pair<int, int>> go;
+      for (auto &succ : successors[k]) {
+        go.emplace_back(succ.symbol,
+                        FindOrMerge(std::move(succ.kernel),
+                                    std::move(succ.look_ahead), succ.hash));
       }
+      states_[level[k]].go = std::move(go);
     }
   }
-#ifndef NDEBUG
-  for (const auto &[k, v] : follow_set_) {
-    ostringstream ss;
-    ss << "Follow [" << k << "]: ";
-    copy(v.begin(), v.end(), ostream_iterator<decltype(v)::value_type>(ss));
-    spdlog::debug("{}", ss.str());
-  }
   FUNC_END_INFO;
-#endif
 }
 
 void Lr1::GenItemGo() {
   FUNC_START_INFO;
-  // 按照 LR1 推导所有产生式
-  lr_item_set_.push_back(Lr1Closure(
-      {LRItem({p_grammar->GetAugmentedToken(), p_grammar->GetEntryToken()},
-              {p_grammar->GetEndingToken()})}));
-
-  for (IdType i = 0; i < lr_item_set_.size(); i++) {
-    // 创建当前的map
-    item_go_map_.emplace_back();
-    auto &curr_go = item_go_map_.back();
-    // 更新方法
-    auto upd_f = [&curr_go, this, i](const Token &tok) {
-      auto &curr_lrs = lr_item_set_[i];
-      auto gone = Lr1GotoFunc(curr_lrs, tok);
-
-      if (!gone.has_value())
-        return;
-#ifndef NDEBUG
-      stringstream ss;
-      for (auto &lri : gone.value()) {
-        copy(lri.GetTokens().begin(), lri.GetTokens().end(),
-             ostream_iterator<Token>(ss, ", "));
-      }
-#endif
-      auto pos = find(lr_item_set_.begin(), lr_item_set_.end(), gone.value());
-
-      IdType new_id = distance(lr_item_set_.begin(), pos);
-
-      if (pos == lr_item_set_.end()) {
-        lr_item_set_.push_back(gone.value());
+  const auto &g = grammar_.value();
+  const TerminalSet none(g.GetTerminatorCount());
+  // 合并后可能有不再可达的状态，按 BFS 顺序重新编号
+  vector<int> new_id(states_.size(), -1), order{0};
+  new_id[0] = 0;
+  for (size_t k = 0; k < order.size(); ++k) {
+    for (auto [sym, target] : states_[order[k]].go) {
+      if (new_id[target] < 0) {
+        new_id[target] = static_cast<int>(order.size());
+        order.push_back(target);
       }
-      if (curr_go.find(tok) != curr_go.end())
-        throw runtime_error("Found shift-in <> shift-in conflict in: " +
-                            tok.GetTokName());
-#ifndef NDEBUG
-      spdlog::debug("GO[ {} ; {} ] = {}", i, tok.ToString(), new_id);
-#endif
-      curr_go.insert({tok, new_id});
-    };
-
-    for_each(p_grammar->GetNonTerminators().cbegin(),
-             p_grammar->GetNonTerminators().cend(), upd_f);
-    for_each(p_grammar->GetTerminators().cbegin(),
-             p_grammar->GetTerminators().cend(), upd_f);
-  }
-#ifndef NDEBUG
-  stringstream ss;
-  for (int i = 0; i < lr_item_set_.size(); ++i) {
-    ss << "Item " << i << ":" << endl;
-    for (const auto &lri : lr_item_set_[i]) {
-      ss << "- " << lri.GetTokens().front() << " -> ";
-      for (size_t j = 1; j <= lri.GetCurrentPosition(); ++j) {
-        ss << lri.GetTokens()[j] << ", ";
-      }
-      ss << "[[^]]";
-      for (size_t j = 1 + lri.GetCurrentPosition(); j < lri.GetTokens().size();
-           ++j) {
-        ss << lri.GetTokens()[j] << ", ";
-      }
-      ss << " [";
-      copy(lri.GetLookAhead().begin(), lri.GetLookAhead().end(),
-           ostream_iterator<Token>(ss, ", "));
-      ss << "] " << endl;
     }
   }
-  spdlog::debug("LRItem Set is as follow:\n{}\n----------", ss.str());
-#endif
+  lr_item_set_.assign(order.size(), {});
+  item_go_map_.assign(order.size(), {});
+  ParallelFor(order.size(), [&](size_t k) {
+    const auto &state = states_[order[k]];
+    for (const auto &[item, la] : g.Lr1Closure(state.kernel, state.look_ahead)) {
+      auto [p, dot] = item;
+      const auto &rhs = g.GetRhs(p);
+      if (dot == rhs.size())
+        lr_item_set_[k].insert(g.MakeItem(p, dot, la));
+      else if (g.IsTerminator(rhs[dot]))
+        lr_item_set_[k].insert(g.MakeItem(p, dot, none));
+    }
+    for (auto [sym, target] : state.go)
+      item_go_map_[k].insert({g.TokenOf(sym), new_id[target]});
+  });
   FUNC_END_INFO;
 }
 
-Lr1::TokenSet Lr1::GetFirst(vector<Token>::const_iterator first,
-                            vector<Token>::const_iterator last) const {
-  if (first == last)
-    return {p_grammar->GetEpsilonToken()};
-  auto tok = *first;
-  if (tok.GetTokenType() == Token::Type::kEpsilon)
-    return {p_grammar->GetEpsilonToken()};
-
-  auto s = first_set_.at(tok);
-  if (s.find(p_grammar->GetEpsilonToken()) != s.end()) {
-    // 当前 First set 有 Epsilon
-    s.merge(GetFirst(first + 1, last));
-  }
-  return s;
+void LrTableGenerateMethod::SetThreadCount(size_t thread_count) {
+  thread_count_ = max<size_t>(thread_count, 1);
 }
 
-unordered_set<LRItem, LRItem::Hash> Lr1::Lr1Closure(LRItemSet lrs) const {
-  bool changed = true;
-  while (changed) {
-    changed = false;
-    for (auto &lri : lrs) {
-      auto next_tok = lri.Next();
-
-      if (!next_tok.has_value())
-        continue;
-
-      if (next_tok->GetTokenType() != Token::Type::kNonTerminator)
-        continue;
-
-      // 找到可以扩张的production id
-      const auto &related_prod =
-          p_grammar->GetTokProdIdMap().at(next_tok.value());
-
-      // 确定 look ahead 符号：
-      auto rest = lri.Rest();
-      auto look_ahead = GetFirst(rest.cbegin() + 1, rest.cend());
-      if (look_ahead.find(p_grammar->GetEpsilonToken()) != look_ahead.end()) {
-        look_ahead.erase(p_grammar->GetEpsilonToken());
-        // epsilon in look_ahead.
-        auto t = lri.GetLookAhead();
-        look_ahead.merge(t);
-      }
-
-      for (auto id : related_prod) {
-        LRItem deferred(p_grammar->GetProductions()[id].GetTokens(), look_ahead,
-                        0);
-        if (lrs.find(deferred) == lrs.end()) {
-          lrs.insert(deferred);
-          changed = true;
-        }
+void LrTableGenerateMethod::ParallelFor(
+    size_t n, const function<void(size_t)> &f) const {
+  if (thread_count_ <= 1 || n <= 1) {
+    for (size_t i = 0; i < n; ++i)
+      f(i);
+    return;
+  }
+  // 每个下标是一个任务，空闲的线程从共享的计数器取下一个，负载自然均衡
+  atomic<size_t> next{0};
+  exception_ptr error;
+  mutex error_mutex;
+  auto worker = [&] {
+    for (size_t i = next++; i < n; i = next++) {
+      try {
+        f(i);
+      } catch (...) {
+        lock_guard<mutex> lock(error_mutex);
+        if (!error)
+          error = current_exception();
+        next = n;
       }
     }
-  }
-
-  // Do merge:
-  LRItemSet merged;
-  for (auto &i : lrs) {
-    auto it = find_if(merged.begin(), merged.end(), [&i](const LRItem &lri) {
-      return lri.GetTokens() == i.GetTokens() &&
-             lri.GetCurrentPosition() == i.GetCurrentPosition();
-    });
+  };
+  vector<thread> workers;
+  for (size_t k = 1; k < min(thread_count_, n); ++k)
+    workers.emplace_back(worker);
+  worker();
+  for (auto &w : workers)
+    w.join();
+  if (error)
+    rethrow_exception(error);
+}
 
-    if (it == merged.end()) {
-      merged.insert(i);
-    } else {
-      auto las = it->GetLookAhead();
-      merged.erase(it);
-      las.merge(unordered_set(i.GetLookAhead()));
-      merged.emplace(i.GetTokens(), las);
-    }
-  }
+const vector<LrTableGenerateMethod::Conflict> &
+LrTableGenerateMethod::GetConflicts() const {
+  return conflicts_;
+}
 
-  return merged;
+size_t LrTableGenerateMethod::GetStateCount() const {
+  return lr_item_set_.size();
 }
 
-void Lr1::GenTable() {
+void LrTableGenerateMethod::GenTable() {
   FUNC_START_INFO;
+  conflicts_.clear();
   lr_table_.Reset();
   lr_table_ = ParsingTable((int)lr_item_set_.size());
   auto aug_terminators = p_grammar->GetTerminators();
   aug_terminators.push_back(p_grammar->GetEpsilonToken());
 
-  for (IdType i = 0; i < item_go_map_.size(); ++i) {
-    auto &curr_lrs = lr_item_set_[i];
+  // 各状态的行互不相关，可以并行填写；冲突按状态顺序汇总
+  vector<vector<Conflict>> conflicts(item_go_map_.size());
+  ParallelFor(item_go_map_.size(), [&](size_t i) {
+    GenTableRow(i, aug_terminators, conflicts[i]);
+  });
+  for (auto &row : conflicts)
+    conflicts_.insert(conflicts_.end(), row.begin(), row.end());
+  lr_table_.SetAugmentedToken(p_grammar->GetAugmentedToken());
+  lr_table_.SetEndingToken(p_grammar->GetEndingToken());
+  lr_table_.SetEntryToken(p_grammar->GetEntryToken());
+  lr_table_.SetEpsilonToken(p_grammar->GetEpsilonToken());
+  lr_table_.SetProductions((p_grammar->GetProductions()));
+  FUNC_END_INFO;
+}
 
-    // 对每一个状态，构建 Action 和 Goto
-    // 1. GOTO
-    for (const auto &tok : p_grammar->GetNonTerminators()) {
-      auto f = item_go_map_[i].find(tok);
-      if (f != item_go_map_[i].end()) {
-        lr_table_.PutGoto(i, tok, f->second);
-      }
-    }
+void LrTableGenerateMethod::GenTableRow(IdType i,
+                                        const vector<Token> &aug_terminators,
+                                        vector<Conflict> &conflicts) {
+  auto &curr_lrs = lr_item_set_[i];
 
-    // 2. Action: 可能有 shift-in <> reduce 冲突，需要解决
-    // 当前的 Item Set
-    for (const auto &tok : aug_terminators) {
-      bool is_accept = false;
-      if (tok == p_grammar->GetEpsilonToken()) {
-        auto it =
-            find_if(curr_lrs.begin(), curr_lrs.end(), [this](const LRItem &v) {
-              return v.GetTokens() ==
-                         vector<Token>{p_grammar->GetAugmentedToken(),
-                                       p_grammar->GetEntryToken()} &&
-                     v.CanReduce();
-            });
-        if (it != curr_lrs.end()) {
-          lr_table_.PutAction(i, p_grammar->GetEndingToken(),
-                              {.action = ParsingTable::kAccept});
-          is_accept = true;
-        }
-      }
-      if (is_accept)
-        continue;
+  // 对每一个状态，构建 Action 和 Goto
+  // 1. GOTO：只看当前状态实际存在的转移
+  for (const auto &[tok, target] : item_go_map_[i]) {
+    if (tok.GetTokenType() == Token::Type::kNonTerminator)
+      lr_table_.PutGoto(i, tok, target);
+  }
 
-      auto f = item_go_map_[i].find(tok);
-      ParsingTable::CellTp shift_in{.action =
-                                        ParsingTable::AutomataAction::kEmpty};
-      if (f != item_go_map_[i].end()) {
-        // 如果可以shift-in
-        shift_in = {.action = ParsingTable::AutomataAction::kShiftIn,
-                    .id = f->second,
-                    .cause = DeferGotoCause(i, f->second, tok)};
-      }
+  // 2. Action: 可能有 shift-in <> reduce 冲突，需要解决
+  // 先遍历一次当前的 Item Set，按终结符收集可规约的产生式与移入的来源产生式
+  bool is_accept = false;
+  unordered_map<Token, vector<IdType>, Token::Hash> reductions;
+  unordered_map<Token, set<IdType>, Token::Hash> shift_causes;
+  for (const auto &lri : curr_lrs) {
+    IdType prod_id = ProductionOf(lri);
+    if (lri.CanReduce()) {
+      // 0 号产生式为增广产生式 S' -> S
+      is_accept = is_accept || prod_id == 0;
+      for (const auto &tok : lri.GetLookAhead())
+        reductions[tok].push_back(prod_id);
+    } else {
+      shift_causes[lri.Next().value()].insert(prod_id);
+    }
+  }
+
+  for (const auto &tok : aug_terminators) {
+    if (is_accept && tok == p_grammar->GetEpsilonToken()) {
+      lr_table_.PutAction(i, p_grammar->GetEndingToken(),
+                          {.action = ParsingTable::kAccept});
+      continue;
+    }
 
-      ParsingTable::CellTp reduce{.action =
+    auto f = item_go_map_[i].find(tok);
+    ParsingTable::CellTp shift_in{.action =
                                       ParsingTable::AutomataAction::kEmpty};
+    if (f != item_go_map_[i].end()) {
+      // 如果可以shift-in
+      const auto &cause = shift_causes[tok];
+      shift_in = {.action = ParsingTable::AutomataAction::kShiftIn,
+                  .id = f->second,
+                  .cause = {cause.begin(), cause.end()}};
+    }
 
-      for (auto &lri : curr_lrs) {
-        if (lri.CanReduce() &&
-            lri.GetLookAhead().find(tok) != lri.GetLookAhead().end()) {
-          auto prod_id = p_grammar->FindProd(lri.GetTokens());
-
-          if (!prod_id.has_value()) {
-            // 没找到 -> 抛出一个异常
-            stringstream ss;
-            copy(lri.GetTokens().cbegin(), lri.GetTokens().cend(),
-                 ostream_iterator<Token>(ss, ", "));
-            throw runtime_error(
-                "LRItem with token not in production list found:\n\t" +
-                ss.str());
-          }
-
-          auto pid = prod_id.value();
-          if (reduce.action != ParsingTable::AutomataAction::kEmpty) {
-            // 已经赋值
-            spdlog::info(
-                "Found Reduce <> Reduce conflict:\n\t{}: \n- with\n{}: {}", pid,
-                p_grammar->GetProductions()[pid].ToString(), reduce.id,
-                p_grammar->GetProductions()[reduce.id].ToString());
-            if (pid < reduce.id) {
-              reduce.id = pid;
-              spdlog::info("Replace!");
-            } else {
-              spdlog::info("Do nothing!");
-            }
-          }
-
-          reduce = ParsingTable::CellTp{
-              .action = ParsingTable::AutomataAction::kReduce,
-              .id = prod_id.value(),
-          };
+    vector<IdType> reduce_ids;
+    if (auto r = reductions.find(tok); r != reductions.end())
+      reduce_ids = r->second;
+
+    ParsingTable::CellTp reduce{.action =
+                                    ParsingTable::AutomataAction::kEmpty};
+    if (!reduce_ids.empty()) {
+      // Reduce <> Reduce 冲突时选择编号最小的产生式
+      sort(reduce_ids.begin(), reduce_ids.end());
+      reduce = ParsingTable::CellTp{
+          .action = ParsingTable::AutomataAction::kReduce,
+          .id = reduce_ids.front(),
+      };
+      if (reduce_ids.size() > 1) {
+        stringstream ss;
+        for (auto pid : reduce_ids)
+          ss << "\t" << pid << ": " << p_grammar->GetProductions()[pid]
+             << endl;
+        spdlog::info("Found Reduce <> Reduce conflict in state {} on {}:\n{}"
+                     "Reduce by {}.",
+                     i, tok.ToString(), ss.str(), reduce.id);
+        conflicts.push_back({i, tok, false, reduce_ids});
+      }
+    }
+
+    if (shift_in.action == ParsingTable::AutomataAction::kEmpty &&
+        reduce.action == ParsingTable::AutomataAction::kEmpty) {
+      lr_table_.PutAction(i, tok, {.action = ParsingTable::kError});
+    } else if (shift_in.action == ParsingTable::AutomataAction::kEmpty &&
+               reduce.action == ParsingTable::AutomataAction::kReduce) {
+      lr_table_.PutAction(i, tok, reduce);
+    } else if (shift_in.action == ParsingTable::AutomataAction::kShiftIn &&
+               reduce.action == ParsingTable::AutomataAction::kEmpty) {
+      lr_table_.PutAction(i, tok, shift_in);
+    } else /* conflict */ {
+      // 生成提示信息
+      stringstream ss;
+      ss << "In state " << i << endl
+         << "Causing Production:\nShiftIn:" << endl;
+      for_each(shift_in.cause.begin(), shift_in.cause.end(),
+               [&ss, this](const auto &v) {
+                 ss << "\t" << v << ": " << p_grammar->GetProductions()[v]
+                    << endl;
+               });
+      ss << "Reduce:" << endl
+         << "\t" << reduce.id << ": "
+         << p_grammar->GetProductions()[reduce.id] << endl;
+      spdlog::info("Found Shift-In <> Reduce Conflict!\n{}", ss.str());
+      conflicts.push_back({i, tok, true, shift_in.cause});
+      conflicts.back().productions.push_back(reduce.id);
+
+      // 处理冲突：
+      // 1. 用结合律分析
+      if (all_of(shift_in.cause.cbegin(), shift_in.cause.cend(),
+                 [this, &reduce, &tok](const IdType &shift_in_prod_id) {
+                   const auto &prod =
+                       p_grammar->GetProductions()[shift_in_prod_id];
+                   const auto &tokens = prod.GetTokens();
+                   if (std::find(tokens.begin(), tokens.end(), tok) ==
+                           tokens.end() ||
+                       tok.GetAttr() == Token::Attr::kNone) {
+                     return false;
+                   }
+                   return true;
+                 })) {
+        // 可以通过结合律解决
+        if (tok.GetAttr() == Token::Attr::kLeftAssociative) {
+          spdlog::info("Reduce. because {} Has LeftAssociative.",
+                       tok.ToString());
+          lr_table_.PutAction(i, tok, reduce);
+        } else {
+          spdlog::info("Shift In. because {} Has RightAssociative.",
+                       tok.ToString());
+          lr_table_.PutAction(i, tok, shift_in);
         }
       }
 
-      if (shift_in.action == ParsingTable::AutomataAction::kEmpty &&
-          reduce.action == ParsingTable::AutomataAction::kEmpty) {
-        lr_table_.PutAction(i, tok, {.action = ParsingTable::kError});
-      } else if (shift_in.action == ParsingTable::AutomataAction::kEmpty &&
-                 reduce.action == ParsingTable::AutomataAction::kReduce) {
+      // 2. 用优先级分析
+      else if (all_of(shift_in.cause.cbegin(), shift_in.cause.cend(),
+                      [&reduce](const auto &v) { return reduce.id < v; })) {
+        // 执行reduce
+        spdlog::info("Reduce. because of prio");
         lr_table_.PutAction(i, tok, reduce);
-      } else if (shift_in.action == ParsingTable::AutomataAction::kShiftIn &&
-                 reduce.action == ParsingTable::AutomataAction::kEmpty) {
+      } else if (all_of(shift_in.cause.cbegin(), shift_in.cause.cend(),
+                        [&reduce](const auto &v) { return reduce.id > v; })) {
+        // 执行 shift in
+        spdlog::info("ShiftIn. because of prio");
         lr_table_.PutAction(i, tok, shift_in);
-      } else /* conflict */ {
-        // 生成提示信息
+      } else {
         stringstream ss;
-        ss << "In state " << i << endl
-           << "Causing Production:\nShiftIn:" << endl;
         for_each(shift_in.cause.begin(), shift_in.cause.end(),
                  [&ss, this](const auto &v) {
-                   ss << "\t" << v << ": " << p_grammar->GetProductions()[v]
-                      << endl;
+                   ss << p_grammar->GetProductions()[v] << endl;
                  });
-        ss << "Reduce:" << endl
-           << "\t" << reduce.id << ": "
-           << p_grammar->GetProductions()[reduce.id] << endl;
-        spdlog::info("Found Shift-In <> Reduce Conflict!\n{}", ss.str());
-
-        // 处理冲突：
-        // 1. 用结合律分析
-        if (all_of(shift_in.cause.cbegin(), shift_in.cause.cend(),
-                   [this, &reduce, &tok](const IdType &shift_in_prod_id) {
-                     const auto &prod =
-                         p_grammar->GetProductions()[shift_in_prod_id];
-                     const auto &tokens = prod.GetTokens();
-                     if (std::find(tokens.begin(), tokens.end(), tok) ==
-                             tokens.end() ||
-                         tok.GetAttr() == Token::Attr::kNone) {
-                       return false;
-                     }
-                     return true;
-                   })) {
-          // 可以通过结合律解决
-          if (tok.GetAttr() == Token::Attr::kLeftAssociative) {
-            spdlog::info("Reduce. because {} Has LeftAssociative.",
-                         tok.ToString());
-            lr_table_.PutAction(i, tok, reduce);
-          } else {
-            spdlog::info("Shift In. because {} Has RightAssociative.",
-                         tok.ToString());
-            lr_table_.PutAction(i, tok, shift_in);
-          }
-        }
-
-        // 2. 用优先级分析
-        else if (all_of(shift_in.cause.cbegin(), shift_in.cause.cend(),
-                        [&reduce](const auto &v) { return reduce.id < v; })) {
-          // 执行reduce
-          spdlog::info("Reduce. because of prio");
-          lr_table_.PutAction(i, tok, reduce);
-        } else if (all_of(shift_in.cause.cbegin(), shift_in.cause.cend(),
-                          [&reduce](const auto &v) { return reduce.id > v; })) {
-          // 执行 shift in
-          spdlog::info("ShiftIn. because of prio");
-          lr_table_.PutAction(i, tok, shift_in);
-        } else {
-          stringstream ss;
-          for_each(shift_in.cause.begin(), shift_in.cause.end(),
-                   [&ss, this](const auto &v) {
-                     ss << p_grammar->GetProductions()[v] << endl;
-                   });
-          spdlog::error(
-              "Cannot Decide shift-in or reduce:\nShift In:\n{}\nReduce:\n{}",
-              ss.str(), p_grammar->GetProductions()[reduce.id].ToString());
-          throw runtime_error("Cannot Decide when generating LR Table!");
-        }
+        spdlog::error(
+            "Cannot Decide shift-in or reduce:\nShift In:\n{}\nReduce:\n{}",
+            ss.str(), p_grammar->GetProductions()[reduce.id].ToString());
+        throw runtime_error("Cannot Decide when generating LR Table!");
       }
     }
   }
-  lr_table_.SetAugmentedToken(p_grammar->GetAugmentedToken());
-  lr_table_.SetEndingToken(p_grammar->GetEndingToken());
-  lr_table_.SetEntryToken(p_grammar->GetEntryToken());
-  lr_table_.SetEpsilonToken(p_grammar->GetEpsilonToken());
-  lr_table_.SetProductions((p_grammar->GetProductions()));
-  FUNC_END_INFO;
 }
 
-vector<IdType> Lr1::DeferGotoCause(IdType lhs, IdType rhs, const Token &tok) {
-  if (lhs >= lr_item_set_.size() || rhs >= lr_item_set_.size())
-    throw runtime_error("Index Out of Range!");
-
-  set<IdType> retval;
+IdType LrTableGenerateMethod::ProductionOf(const LRItem &item) const {
+  auto prod_id = item.GetProductionId();
+  if (!prod_id.has_value())
+    prod_id = p_grammar->FindProd(item.GetTokens());
+  if (!prod_id.has_value()) {
+    // 没找到 -> 抛出一个异常
+    stringstream ss;
+    copy(item.GetTokens().cbegin(), item.GetTokens().cend(),
+         ostream_iterator<Token>(ss, ", "));
+    throw runtime_error("LRItem with token not in production list found:\n\t" +
+                        ss.str());
+  }
+  return prod_id.value();
+}
 
-  for (const auto &k : lr_item_set_[lhs]) {
-    auto opt_next_tok = k.Defer(tok);
+void Lalr::Defer(const ContextFreeGrammar &cfg) {
+  p_grammar = &cfg;
+  grammar_.emplace(cfg);
+  GenLr0();
+  GenLookAhead();
+  GenItemGo();
+  GenTable();
+  ReportConflicts();
+}
 
-    if (!opt_next_tok.has_value())
+vector<Lalr::Item> Lalr::Lr0Closure(const vector<Item> &kernel) const {
+  const auto &g = grammar_.value();
+  vector<Item> items = kernel;
+  vector<bool> expanded(g.GetSymbolCount(), false);
+  for (size_t k = 0; k < items.size(); ++k) {
+    auto [p, dot] = items[k];
+    const auto &rhs = g.GetRhs(p);
+    if (dot >= rhs.size() || g.IsTerminator(rhs[dot]) || expanded[rhs[dot]])
       continue;
+    expanded[rhs[dot]] = true;
+    for (auto q : g.GetProductionsOf(rhs[dot]))
+      items.emplace_back(q, 0);
+  }
+  return items;
+}
+
+int Lalr::GoOf(IdType state, int symbol) const {
+  const auto &go = go_[state];
+  auto it = lower_bound(go.begin(), go.end(), make_pair(symbol, INT_MIN));
+  if (it == go.end() || it->first != symbol)
+    return -1;
+  return it->second;
+}
+
+void Lalr::GenLr0() {
+  FUNC_START_INFO;
+  const auto &g = grammar_.value();
+  kernels_.clear();
+  go_.clear();
+  map<vector<Item>, int> kernel_id;
+  kernels_.push_back({{0, 0}});
+  kernel_id.insert({kernels_.front(), 0});
+  for (IdType i = 0; i < kernels_.size(); ++i) {
+    // 按圆点后的符号分组，只对这些符号求 GO
+    map<int, vector<Item>> next;
+    for (auto [p, dot] : Lr0Closure(kernels_[i])) {
+      if (dot < g.GetRhs(p).size())
+        next[g.GetRhs(p)[dot]].emplace_back(p, dot + 1);
+    }
+    go_.emplace_back();
+    for (auto &[sym, kernel] : next) {
+      sort(kernel.begin(), kernel.end());
+      auto f = kernel_id.find(kernel);
+      int target;
+      if (f == kernel_id.end()) {
+        target = static_cast<int>(kernels_.size());
+        kernel_id.insert({kernel, target});
+        kernels_.push_back(std::move(kernel));
+      } else {
+        target = f->second;
+      }
+      go_[i].emplace_back(sym, target);
+    }
+  }
+  spdlog::info("LALR: {} LR(0) states.", kernels_.size());
+  FUNC_END_INFO;
+}
+
+void Lalr::GenLookAhead() {
+  FUNC_START_INFO;
+  const auto &g = grammar_.value();
+  const size_t n_states = kernels_.size();
+  const size_t n_symbols = g.GetSymbolCount();
+
+  // 1. 非终结符上的转移 (p, A)
+  vector<pair<int, int>> trans;
+  unordered_map<size_t, int> trans_id;
+  for (IdType p = 0; p < n_states; ++p) {
+    for (auto [sym, target] : go_[p]) {
+      if (!g.IsTerminator(sym)) {
+        trans_id.insert({p * n_symbols + sym, static_cast<int>(trans.size())});
+        trans.emplace_back(p, sym);
+      }
+    }
+  }
+  auto trans_of = [&](int p, int sym) {
+    return trans_id.at(static_cast<size_t>(p) * n_symbols + sym);
+  };
+
+  // 2. DR 与 reads：从 GO(p, A) 出发直接读入的终结符，以及经可空非终结符的传递
+  vector<TerminalSet> sets(trans.size(), TerminalSet(g.GetTerminatorCount()));
+  vector<vector<int>> reads(trans.size());
+  for (size_t x = 0; x < trans.size(); ++x) {
+    int r = GoOf(trans[x].first, trans[x].second);
+    for (auto [sym, target] : go_[r]) {
+      if (g.IsTerminator(sym))
+        sets[x].Set(sym);
+      else if (g.IsNullable(sym))
+        reads[x].push_back(trans_of(r, sym));
+    }
+  }
+  // 增广产生式 S' -> S 之后为结束符
+  sets[trans_of(0, g.GetRhs(0).front())].Set(
+      g.SymbolOf(p_grammar->GetEndingToken()));
+  Digraph(reads, sets);
+
+  // 3. includes 与 lookback
+  vector<vector<int>> includes(trans.size());
+  vector<unordered_map<IdType, vector<int>>> lookback(n_states);
+  for (size_t x = 0; x < trans.size(); ++x) {
+    auto [from, lhs] = trans[x];
+    for (auto prod : g.GetProductionsOf(lhs)) {
+      const auto &rhs = g.GetRhs(prod);
+      // rhs[nullable_from..] 均可空
+      size_t nullable_from = rhs.size();
+      while (nullable_from > 0 && g.IsNullable(rhs[nullable_from - 1]))
+        --nullable_from;
+      int p = from;
+      for (size_t k = 0; k < rhs.size(); ++k) {
+        if (!g.IsTerminator(rhs[k]) && k + 1 >= nullable_from)
+          includes[trans_of(p, rhs[k])].push_back(static_cast<int>(x));
+        p = GoOf(p, rhs[k]);
+      }
+      lookback[p][prod].push_back(static_cast<int>(x));
+    }
+  }
+  Digraph(includes, sets);
+
+  // 4. LA(q, A -> w) = U Follow(p, A)，(q, A -> w) lookback (p, A)
+  look_ahead_.assign(n_states, {});
+  for (IdType q = 0; q < n_states; ++q) {
+    for (const auto &[prod, xs] : lookback[q]) {
+      auto &la = look_ahead_[q]
+                     .insert({prod, TerminalSet(g.GetTerminatorCount())})
+                     .first->second;
+      for (int x : xs)
+        la.Merge(sets[x]);
+    }
+  }
+  FUNC_END_INFO;
+}
 
-    auto next_lri = opt_next_tok.value();
+void Lalr::GenItemGo() {
+  FUNC_START_INFO;
+  const auto &g = grammar_.value();
+  const TerminalSet none(g.GetTerminatorCount());
+  lr_item_set_.clear();
+  item_go_map_.clear();
+  for (IdType q = 0; q < kernels_.size(); ++q) {
+    LRItemSet items;
+    for (auto [p, dot] : Lr0Closure(kernels_[q])) {
+      auto f = look_ahead_[q].find(p);
+      bool reducible = dot == g.GetRhs(p).size() && f != look_ahead_[q].end();
+      items.insert(g.MakeItem(p, dot, reducible ? f->second : none));
+    }
+    lr_item_set_.push_back(std::move(items));
+    item_go_map_.emplace_back();
+    for (auto [sym, target] : go_[q])
+      item_go_map_.back().insert({g.TokenOf(sym), target});
+  }
+  FUNC_END_INFO;
+}
 
-    if (lr_item_set_[rhs].find(next_lri) ==
-        lr_item_set_[rhs].end()) // lhs -[tok]-> rhs 不成立
+void Lalr::ReportConflicts() const {
+  size_t shift_reduce = 0, reduce_reduce = 0;
+  for (const auto &conflict : conflicts_) {
+    if (conflict.shift_reduce) {
+      ++shift_reduce;
       continue;
+    }
+    ++reduce_reduce;
+    stringstream ss;
+    for (auto pid : conflict.productions)
+      ss << "\t" << pid << ": " << p_grammar->GetProductions()[pid] << endl;
+    spdlog::warn("LALR: Reduce <> Reduce conflict in state {} on {}, which "
+                 "may be introduced by merging LR(1) states with the same "
+                 "core:\n{}",
+                 conflict.state, conflict.token.ToString(), ss.str());
+  }
+  spdlog::info("LALR: {} states, {} Shift-In <> Reduce conflicts, {} Reduce "
+               "<> Reduce conflicts.",
+               kernels_.size(), shift_reduce, reduce_reduce);
+}
 
-    // 找到对应production
-    auto opt_pid = p_grammar->FindProd(k.GetTokens());
-    if (!opt_pid.has_value()) {
-      // 没找到 -> 抛出一个异常
-      stringstream ss;
-      copy(k.GetTokens().cbegin(), k.GetTokens().cend(),
-           ostream_iterator<Token>(ss, ", "));
-      throw runtime_error(
-          "LRItem with token not in production list found:\n\t" + ss.str());
+void MinimalLr1::Defer(const ContextFreeGrammar &cfg) {
+  p_grammar = &cfg;
+  grammar_.emplace(cfg);
+  split_tokens_ = TerminalSet(grammar_->GetTerminatorCount());
+  core_states_.clear();
+  merge_count_ = 0;
+  GenStates();
+  GenItemGo();
+  GenTable();
+  if (!conflicts_.empty()) {
+    // 冲突的解决结果不能因合并而扩散，在冲突终结符上按 Lr1 拆分后重新构造
+    for (const auto &conflict : conflicts_)
+      split_tokens_.Set(grammar_->SymbolOf(conflict.token));
+    spdlog::info("Minimal LR(1): {} states with {} conflicts, rebuilding "
+                 "without merging on conflicting tokens.",
+                 lr_item_set_.size(), conflicts_.size());
+    core_states_.clear();
+    GenStates();
+    GenItemGo();
+    GenTable();
+  }
+  spdlog::info("Minimal LR(1): {} states, {} merges, {} conflicts.",
+               lr_item_set_.size(), merge_count_, conflicts_.size());
+}
+
+bool MinimalLr1::IsWeaklyCompatible(const vector<TerminalSet> &l,
+                                    const vector<TerminalSet> &m) {
+  for (size_t i = 0; i < l.size(); ++i) {
+    for (size_t j = i + 1; j < l.size(); ++j) {
+      if (!l[i].Intersects(m[j]) && !l[j].Intersects(m[i]))
+        continue;
+      if (l[i].Intersects(l[j]) || m[i].Intersects(m[j]))
+        continue;
+      return false;
     }
-    IdType prod_id = opt_pid.value();
-    retval.emplace(prod_id);
   }
-  return {retval.begin(), retval.end()};
+  return true;
+}
+
+bool MinimalLr1::AgreesOnSplitTokens(const vector<TerminalSet> &l,
+                                     const vector<TerminalSet> &m) const {
+  for (size_t k = 0; k < l.size(); ++k) {
+    if (!l[k].EqualsOn(m[k], split_tokens_))
+      return false;
+  }
+  return true;
 }
+
+int MinimalLr1::FindOrMerge(vector<Item> kernel,
+                            vector<TerminalSet> look_ahead, size_t) {
+  auto &candidates = core_states_[kernel];
+  // 1. 已有状态的向前看符号包含新项集（且在 split_tokens_ 上相同）的，直接使用
+  for (int s : candidates) {
+    const auto &la = states_[s].look_ahead;
+    bool subset = AgreesOnSplitTokens(la, look_ahead);
+    for (size_t k = 0; subset && k < la.size(); ++k)
+      subset = look_ahead[k].IsSubsetOf(la[k]);
+    if (subset)
+      return s;
+  }
+  // 2. 与弱相容（且在 split_tokens_ 上相同）的状态合并，向前看符号增加后需要重新展开
+  for (int s : candidates) {
+    auto &la = states_[s].look_ahead;
+    if (!IsWeaklyCompatible(la, look_ahead) ||
+        !AgreesOnSplitTokens(la, look_ahead))
+      continue;
+    for (size_t k = 0; k < la.size(); ++k)
+      la[k].Merge(look_ahead[k]);
+    ++merge_count_;
+    Enqueue(s);
+    return s;
+  }
+  // 3. 新建状态
+  int s = AddState(std::move(kernel), std::move(look_ahead));
+  candidates.push_back(s);
+  return s;
+}
+
 } // namespace sly::core::grammar
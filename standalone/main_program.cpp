@@ -34,9 +34,9 @@ using namespace std;
  * Defs <- DefsLine Defs | lbrace Codes rbrace | 
  * Codes <- CodesLine Codes | 
  * CodesLine <- line {}
- * DefsLine <- line {word blank RegEx "\n"}
+ * DefsLine <- line {word blank RegEx "\n" | ("%s" | "%x") blank word blank ... "\n"}
  * Rules <- RulesLine Rules | 
- * RulesLine <- line {LexRegEx blank CodePart "\n"}
+ * RulesLine <- line {["<" word "," word ... ">"] LexRegEx blank CodePart "\n"}
  * Sub <- SubLine Sub | 
  * SubLine <- line {}
  **/
@@ -62,11 +62,19 @@ struct LexParms {
   struct LexRule {
     string exp;
     string code;
+    vector<string> conditions;
+  };
+  struct StartCondition {
+    string name;
+    bool exclusive;
   };
 
   // lexDef = {{name: "D", regex: "[0-9]"}, {name: "L", regex: "[a-zA-Z]"}, ...}
   vector<LexDef> lexDefs;
-  // lexRule = {{exp: "0[0-7]*{IS}?", code: "{ count(); retur(CONSTANT) }"}, ...}
+  // startConditions = {{name: "COMMENT", exclusive: true}, ...}  (%x COMMENT)
+  vector<StartCondition> startConditions;
+  // lexRule = {{exp: "0[0-7]*{IS}?", code: "{ count(); retur(CONSTANT) }", conditions: {}}, ...}
+  // conditions 为空表示没有 <COND> 前缀，"*" 表示所有条件
   vector<LexRule>  lexRules;
   // headCodeblock = "#include <stdio.h>\n#include "y.tab.h"\n..."
   string headCodeblock;
@@ -98,12 +106,18 @@ struct Parms {
   struct lexToken {
     string regex;
     string action;
+    // 该规则活跃的起始条件编号（升序）
+    vector<int> conditions;
   };
   struct Prod {
     string startToken;
     vector<string> nextTokens;
   };
   vector<lexToken> lexTokens;
+  // startConditions = {"INITIAL", "COMMENT", ...}，下标为条件编号
+  vector<string> startConditions;
+  // 关键字规则（被标识符等规则覆盖的字符串常量）不进入 DFA，由生成的关键字表识别
+  bool keywordTable = true;
   string startToken;
   set<string> terminalTokens;
   set<string> nonTerminalTokens;
@@ -149,8 +163,40 @@ Parms ParseParameters(LexParms lexParms, YaccParms yaccParms) {
     }
     return ss.str();
   };
+  // initialize startConditions
+  // 没有前缀的规则在 INITIAL 和所有 %s（inclusive）条件下活跃，%x（exclusive）条件只含显式标注的规则
+  parms.startConditions.push_back("INITIAL");
+  vector<int> unprefixedConditions = {0};
+  for (const auto &[name, exclusive] : lexParms.startConditions) {
+    if (!exclusive) {
+      unprefixedConditions.push_back(parms.startConditions.size());
+    }
+    parms.startConditions.push_back(name);
+  }
+  auto conditionId = [&parms](const string &name) -> int {
+    auto it = find(parms.startConditions.begin(), parms.startConditions.end(), name);
+    if (it == parms.startConditions.end()) {
+      spdlog::error("undefined start condition <{}>", name);
+      throw runtime_error("Undefined start condition.");
+    }
+    return it - parms.startConditions.begin();
+  };
   // initialize lexTokens
   for (auto rule : lexParms.lexRules) {
+    vector<int> conditions;
+    if (rule.conditions.empty()) {
+      conditions = unprefixedConditions;
+    } else if (rule.conditions == vector<string>{"*"}) {
+      for (size_t i = 0; i < parms.startConditions.size(); i++) {
+        conditions.push_back(static_cast<int>(i));
+      }
+    } else {
+      for (const string &name : rule.conditions) {
+        conditions.push_back(conditionId(name));
+      }
+      sort(conditions.begin(), conditions.end());
+      conditions.erase(unique(conditions.begin(), conditions.end()), conditions.end());
+    }
     // transform lex-regex to regex
     rule.exp = lexRegex2regex(rule.exp);
     // replace {D} with its regex
@@ -160,7 +206,7 @@ Parms ParseParameters(LexParms lexParms, YaccParms yaccParms) {
       auto &regex = it->regex;
       replace_all(rule.exp, "{" + name + "}", regex);
     }
-    parms.lexTokens.push_back({rule.exp, rule.code});
+    parms.lexTokens.push_back({rule.exp, rule.code, conditions});
   }
 
   parms.startToken = yaccParms.yaccStartToken;
@@ -192,9 +238,17 @@ void LexParms::Print(ostream &oss) const{
     for (const auto &lexDef : lexDefs) {
       oss << "  " << lexDef.name << ": " << lexDef.regex << endl;
     }
+    oss << "Start Conditions: " << endl;
+    for (const auto &startCondition : startConditions) {
+      oss << "  " << (startCondition.exclusive ? "%x " : "%s ") << startCondition.name << endl;
+    }
     oss << "Rules: " << endl;
     for (const auto &lexRule : lexRules) {
-      oss << "  " << lexRule.exp << ": " << endl;
+      oss << "  ";
+      for (const auto &condition : lexRule.conditions) {
+        oss << "<" << condition << ">";
+      }
+      oss << lexRule.exp << ": " << endl;
       oss << "    " << lexRule.code << endl;
     }
     oss << "Head Codeblock: " << endl;
@@ -224,9 +278,17 @@ void YaccParms::Print(ostream &oss) const{
   }
 
 void Parms::Print(ostream &oss) const {
+  oss << "Start Conditions: " << endl;
+  for (size_t i = 0; i < startConditions.size(); i++) {
+    oss << "  " << i << ": " << startConditions[i] << endl;
+  }
   oss << "Lex Tokens: " << endl;
-  for (const auto &[regex, action] : lexTokens) {
-    oss << "  " << regex << ": " << endl;
+  for (const auto &[regex, action, conditions] : lexTokens) {
+    oss << "  " << regex << ": ";
+    for (int condition : conditions) {
+      oss << condition << " ";
+    }
+    oss << endl;
     oss << "    " << action << endl;
   }
   oss << "Token Terminators: " << endl;
@@ -306,6 +368,17 @@ LexParms ParseLexParameters(stringstream &file_stream) {
             // DefsLine: word blank RegEx
             // TODO
             const string &str = v[1].Get<string>("lval");
+            if (str.size() > 2 && (str.compare(0, 2, "%x") == 0 || str.compare(0, 2, "%s") == 0)
+                && (str[2] == ' ' || str[2] == '\t')) {
+              // DefsLine: %x word word ... 
+              bool exclusive = str[1] == 'x';
+              stringstream ss(str.substr(2));
+              string name;
+              while (ss >> name) {
+                lexParms.startConditions.push_back({name, exclusive});
+              }
+              return;
+            }
             size_t pos = str.find_first_of(" \t\n\r\0");
             string defName = str.substr(0, pos);
             string defRegex = str.substr(pos + 1);
@@ -321,15 +394,26 @@ LexParms ParseLexParameters(stringstream &file_stream) {
           }}),
         // RulesLine <- line
         Production(RulesLine, {[&lexParms](vector<YYSTATE> &v) {
-            // RulesLine: LexRegEx blank CodePart
+            // RulesLine: [<COND,COND>] LexRegEx blank CodePart
             // TODO
-            const string &str = v[1].Get<string>("lval");
+            string str = v[1].Get<string>("lval");
+            vector<string> conditions;
+            size_t close = str.find('>');
+            if (!str.empty() && str[0] == '<' && close != string::npos && close > 1 &&
+                str.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_,*", 1) == close) {
+              stringstream ss(str.substr(1, close - 1));
+              string name;
+              while (getline(ss, name, ',')) {
+                conditions.push_back(name);
+              }
+              str = str.substr(close + 1);
+            }
             size_t pos = min(str.find(" {"), str.find("\t{"));
             string lexRegEx = str.substr(0, pos);
             string codePart = str.substr(pos + 1);
             sly::utils::trim(lexRegEx, " \t\n\r\0");
             sly::utils::trim(codePart, " \t\n\r\0");
-            lexParms.lexRules.push_back({lexRegEx, codePart});
+            lexParms.lexRules.push_back({lexRegEx, codePart, conditions});
           }})(line),
         // Sub <- SubLine Sub
         Production(Sub, {[](vector<YYSTATE> &v) {
@@ -572,6 +656,7 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
   oss1 << R"(#include "sly/FaModel.h")" << endl;
   oss1 << R"(#include "sly/LrParser.h")" << endl;
   oss1 << R"(#include "sly/RegEx.h")" << endl;
+  oss1 << R"(#include "sly/SeuLex.h")" << endl;
   oss1 << R"(#include "sly/Stream2TokenPipe.h")" << endl;
   oss1 << R"(#include <sly/sly.h>)" << endl;
   oss1 << R"()" << endl;
@@ -586,6 +671,8 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
   oss1 << R"(using sly::core::lexical::RegEx;)" << endl;
   oss1 << R"(using sly::core::lexical::DfaModel;)" << endl;
   oss1 << R"(using sly::runtime::Stream2TokenPipe;)" << endl;
+  oss1 << R"(using sly::runtime::SeuLex;)" << endl;
+  oss1 << R"(using sly::runtime::TextView;)" << endl;
   oss1 << R"(using sly::core::grammar::LrParser;)" << endl;
   oss1 << R"(using namespace std;)" << endl;
   oss1 << endl;
@@ -629,6 +716,15 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
     oss1 << "#define " << tokenName << " " << tokenIdx++ << endl;
   }
   oss1 << endl;
+  oss1 << "// start conditions" << endl;
+  oss1 << "//@variable" << endl;
+  for (size_t i = 0; i < parms.startConditions.size(); i++) {
+    oss1 << "#define " << parms.startConditions[i] << " " << i << endl;
+  }
+  // 与 flex 相同，BEGIN NAME; 与 BEGIN(NAME); 两种写法都可以使用
+  oss1 << "#define BEGIN YYBegin{} =" << endl;
+  oss1 << "#define YY_START lexer.GetCondition()" << endl;
+  oss1 << endl;
 
   /* section 3 */
   oss1 << "/* section 3 */" << endl;
@@ -673,29 +769,48 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
   oss1 << "// lexical" << endl;
   oss1 << "//@variable" << endl;
   oss1 << "vector<Token> lexical_tokens = {" << endl;
-  for (const auto &[regex, action] : parms.lexTokens) {
+  for (const auto &[regex, action, conditions] : parms.lexTokens) {
     oss1 << "  Token::Terminator(R\"(" << regex << ")\"), "<< endl;
   }
   oss1 << "};" << endl;
   oss1 << "vector<DfaModel> lexical_tokens_dfa = {" << endl;
-  for (const auto &[regex, action] : parms.lexTokens) {
+  for (const auto &[regex, action, conditions] : parms.lexTokens) {
     oss1 << "  RegEx(R\"(" << regex << ")\").GetDfaModel(), "<< endl;
   }
   oss1 << "};" << endl;
+  oss1 << "// rules active in each start condition" << endl;
+  oss1 << "//@variable" << endl;
+  oss1 << "vector<vector<int>> condition_rules = {" << endl;
+  for (size_t i = 0; i < parms.startConditions.size(); i++) {
+    oss1 << "  {";
+    for (int j = 0; j < num_lexical_tokens; j++) {
+      const auto &conditions = parms.lexTokens[j].conditions;
+      if (binary_search(conditions.begin(), conditions.end(), static_cast<int>(i))) {
+        oss1 << j << ", ";
+      }
+    }
+    oss1 << "}, // " << parms.startConditions[i] << endl;
+  }
+  oss1 << "};" << endl;
+  oss1 << "//@variable" << endl;
+  oss1 << "const bool use_keyword_table = " << (parms.keywordTable ? "true" : "false") << ";" << endl;
   oss1 << endl;
 
   /* section 5 */
   oss1 << R"(/* section 5 */)" << endl;
-  oss1 << R"(stringstream input_stream;)" << endl;
-  oss1 << R"(Stream2TokenPipe s2ppl;)" << endl;
-  oss1 << R"(string yytext;)" << endl;
+  oss1 << R"(SeuLex lexer;)" << endl;
+  oss1 << R"(struct YYBegin {)" << endl;
+  oss1 << R"(  void operator=(int condition) const { lexer.Begin(condition); })" << endl;
+  oss1 << R"(};)" << endl;
+  oss1 << R"(TextView yytext;)" << endl;
   oss1 << R"()" << endl;
   oss1 << R"(char input() {)" << endl;
-  oss1 << R"(  return s2ppl.input(input_stream);)" << endl;
+  oss1 << R"(  return lexer.Input();)" << endl;
   oss1 << R"(})" << endl;
   oss1 << R"()" << endl;
+  oss1 << R"(// 与 flex 相同：c 写在刚读过的字符的位置上，之后先读到 c)" << endl;
   oss1 << R"(void unput(char c) {)" << endl;
-  oss1 << R"(  s2ppl.unput(input_stream, c);)" << endl;
+  oss1 << R"(  lexer.Unput(c);)" << endl;
   oss1 << R"(})" << endl;
   oss1 << endl;
 
@@ -708,16 +823,16 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
   /* section 6 */
   oss1 << "/* section 6 */" << endl;
   oss1 << "//@variable" << endl;
-  oss1 << "IdType to_syntax_token_id(Token lexical_token, AttrDict &ad) {" << endl;
-  oss1 << "  string token_name = lexical_token.GetTokName();" << endl;
-  oss1 << "  ";
-  for (const auto &[regex, action] : parms.lexTokens) {
-    oss1 << "if (token_name == R\"(" << regex << ")\") { " << endl;
-    oss1 << "    { " << action << "}" << endl;
-    oss1 << "  } else ";
+  // 按扫描器给出的规则编号（lexical_tokens 的下标）分派用户动作
+  oss1 << "IdType to_syntax_token_id(int rule, AttrDict &ad) {" << endl;
+  oss1 << "  switch (rule) {" << endl;
+  for (int i = 0; i < num_lexical_tokens; i++) {
+    oss1 << "  case " << i << ":" << endl;
+    oss1 << "    { " << parms.lexTokens[i].action << "}" << endl;
+    oss1 << "    break;" << endl;
   }
-  oss1 << " {" << endl;
-  oss1 << "    return 0;" << endl;
+  oss1 << "  default:" << endl;
+  oss1 << "    break;" << endl;
   oss1 << "  }" << endl;
   oss1 << "  return 0;" << endl;
   oss1 << "}" << endl;
@@ -736,9 +851,24 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
   /* section 7.3 */
   oss1 << R"(
   /* section 7.3 */
-  // lexical
-  auto [transition, state] = sly::core::lexical::DfaModel::Merge(lexical_tokens_dfa);
-  s2ppl = Stream2TokenPipe(transition, state, lexical_tokens, ending);
+  // lexical: each start condition gets its own table
+  lexer = SeuLex(lexical_tokens, ending);
+  for (size_t condition = 0; condition < condition_rules.size(); condition++) {
+    vector<int> rules = condition_rules[condition];
+    sly::runtime::KeywordTable keywords;
+    if (use_keyword_table)
+      tie(rules, keywords) = sly::runtime::KeywordTable::Extract(lexical_tokens_dfa, rules);
+    vector<DfaModel> dfa_list;
+    for (int rule : rules) {
+      dfa_list.push_back(lexical_tokens_dfa[rule]);
+    }
+    auto [transition, state] = sly::core::lexical::DfaModel::Merge(dfa_list);
+    for (auto &rule : state) {
+      if (rule >= 0)
+        rule = rules[rule];
+    }
+    lexer.AddCondition(transition, state, std::move(keywords));
+  }
   // syntax
   sly::core::grammar::ParsingTable table;
 
@@ -753,37 +883,30 @@ void generateCodeFile(Parms parms, ostream &oss_code, ostream &oss_precompile) {
   oss1 << R"(
   /* section 7.4 */
   // runtime
-  {
-    ifstream inputFile(")" CPP_INPUT_ORIGINAL_PATH R"(");
-              input_stream
-       << inputFile.rdbuf();
-  inputFile.close();
-  }
+  lexer.Open(")" CPP_INPUT_ORIGINAL_PATH R"(");
 
   // lexical
    vector<AttrDict> attributes;
    vector<Token> tokens;
    while (true) {
-     auto lexical_token = s2ppl.Defer(input_stream);
+     auto lexeme = lexer.Lex();
+     const auto &lexical_token = lexer.GetToken(lexeme);
 
+     // 词文只记录为指向输入缓冲区的视图
      AttrDict ad;
-     ad.Set("lval", s2ppl.buffer_); 
-     ad.Set("row", s2ppl.token_begin_row_);
-     ad.Set("col", s2ppl.token_begin_col_);
-     yytext = s2ppl.buffer_;
+     ad.SetLexeme(lexer.Text(lexeme), lexeme.offset, &lexer);
+     yytext = lexer.Text(lexeme);
 
-     Token syntax_token;
-     if (lexical_token == ending) {
-       syntax_token = ending;
-     } else {
-       IdType id = to_syntax_token_id(lexical_token, ad);
+     IdType id = 0;
+     if (lexical_token != ending) {
+       id = to_syntax_token_id(lexeme.rule, ad);
        if (id == 0) 
          continue;
-       syntax_token = syntax_tokens[id];
      }
+     const Token &syntax_token = lexical_token == ending ? ending : syntax_tokens[id];
 
      tokens.emplace_back(syntax_token);
-     attributes.emplace_back(ad);
+     attributes.emplace_back(std::move(ad));
 
      // cerr << syntax_token.ToString() << " ";
 
@@ -1753,7 +1753,7 @@ char input() {
 }
 
 void unput(char c) {
-  s2ppl.unput(input_stream, c);
+  s2ppl.unput(c);
 }
 
 /* user code from lex file start */
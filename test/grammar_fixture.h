@@ -0,0 +1,176 @@
+/**
+ * @file grammar_fixture.h
+ * @brief 文法测试共用的工具：读入 yacc 文件的规则段、随机生成句子、与状态编号无关地比较冲突
+ */
+
+#ifndef SEULEXYACC_GRAMMAR_FIXTURE_H
+#define SEULEXYACC_GRAMMAR_FIXTURE_H
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 读入 yacc 文件的规则段，只处理 %token、%start 与不带动作的规则，
+ * 文件无法打开或没有规则时抛出 runtime_error
+ */
+inline std::vector<sly::core::type::Production>
+load_grammar(const std::string &path, sly::core::type::Token &start) {
+  using sly::core::type::Production;
+  using sly::core::type::Token;
+  std::ifstream file(path);
+  if (!file) {
+    spdlog::error("load_grammar: cannot open {} (run the test from the test directory "
+                  "or pass a yacc file).", path);
+    throw std::runtime_error("Cannot open file: " + path);
+  }
+  std::string word;
+  std::vector<std::string> words;
+  bool in_rules = false;
+  std::string start_name;
+  while (file >> word) {
+    if (word == "%%") {
+      if (in_rules)
+        break;
+      in_rules = true;
+    } else if (!in_rules && word == "%start") {
+      file >> start_name;
+    } else if (in_rules) {
+      words.push_back(word);
+    }
+  }
+  if (words.empty()) {
+    spdlog::error("load_grammar: no rules found in {}.", path);
+    throw std::runtime_error("Invalid yacc file: " + path);
+  }
+  // 规则左部都是非终结符，其余为终结符
+  std::map<std::string, bool> is_non_terminator;
+  for (size_t i = 0; i + 1 < words.size(); ++i) {
+    if (words[i + 1] == ":")
+      is_non_terminator[words[i]] = true;
+  }
+  auto token_of = [&is_non_terminator](const std::string &name) {
+    if (is_non_terminator.count(name))
+      return Token::NonTerminator(name);
+    return Token::Terminator(name);
+  };
+  std::vector<Production> productions;
+  for (size_t i = 0; i < words.size();) {
+    Token lhs = token_of(words[i]);
+    i += 2;
+    Production prod(lhs);
+    bool empty = true;
+    for (; i < words.size(); ++i) {
+      if (words[i] == "|" || words[i] == ";") {
+        productions.push_back(empty ? prod(Token()) : prod);
+        prod = Production(lhs);
+        empty = true;
+        if (words[i] == ";") {
+          ++i;
+          break;
+        }
+      } else {
+        prod = prod(token_of(words[i]));
+        empty = false;
+      }
+    }
+  }
+  start = token_of(start_name.empty() ? words.front() : start_name);
+  return productions;
+}
+
+/**
+ * 随机推导出一个句子，深度超过 max_depth 后选择推导最浅的候选式
+ */
+class SentenceGenerator {
+ public:
+  using Production = sly::core::type::Production;
+  using Token = sly::core::type::Token;
+
+  SentenceGenerator(const std::vector<Production> &productions, unsigned seed)
+      : productions_(productions), rng_(seed) {
+    for (size_t p = 0; p < productions.size(); ++p)
+      alternatives_[productions[p].GetTokens().front()].push_back(p);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (const auto &prod : productions) {
+        int h = 0;
+        for (size_t k = 1; k < prod.GetTokens().size(); ++k)
+          h = std::max(h, Height(prod.GetTokens()[k]));
+        if (h != INT_MAX && h + 1 < Height(prod.GetTokens().front())) {
+          height_[prod.GetTokens().front()] = h + 1;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  void Derive(const Token &tok, int depth, int max_depth, std::vector<Token> &out) {
+    if (tok.GetTokenType() == Token::Type::kEpsilon)
+      return;
+    if (tok.IsTerminator()) {
+      out.push_back(tok);
+      return;
+    }
+    const auto &alts = alternatives_.at(tok);
+    size_t p = alts[rng_() % alts.size()];
+    if (depth >= max_depth) {
+      for (auto q : alts) {
+        if (ProdHeight(q) < ProdHeight(p))
+          p = q;
+      }
+    }
+    const auto &tokens = productions_[p].GetTokens();
+    for (size_t k = 1; k < tokens.size(); ++k)
+      Derive(tokens[k], depth + 1, max_depth, out);
+  }
+
+ private:
+  int Height(const Token &tok) const {
+    if (tok.GetTokenType() != Token::Type::kNonTerminator)
+      return 0;
+    auto f = height_.find(tok);
+    return f == height_.end() ? INT_MAX : f->second;
+  }
+
+  int ProdHeight(size_t p) const {
+    int h = 0;
+    for (size_t k = 1; k < productions_[p].GetTokens().size(); ++k)
+      h = std::max(h, Height(productions_[p].GetTokens()[k]));
+    return h;
+  }
+
+  const std::vector<Production> &productions_;
+
+  std::mt19937 rng_;
+
+  std::unordered_map<Token, std::vector<size_t>, Token::Hash> alternatives_;
+
+  std::unordered_map<Token, int, Token::Hash> height_;
+};
+
+/**
+ * 冲突按 {种类, token, 产生式} 比较，与状态编号无关
+ */
+inline std::set<std::tuple<bool, std::string, std::vector<IdType>>>
+conflict_set(const sly::core::grammar::LrTableGenerateMethod &method) {
+  std::set<std::tuple<bool, std::string, std::vector<IdType>>> result;
+  for (const auto &c : method.GetConflicts()) {
+    auto prods = c.productions;
+    std::sort(prods.begin(), prods.end());
+    result.emplace(c.shift_reduce, c.token.GetTokName(), prods);
+  }
+  return result;
+}
+
+#endif //SEULEXYACC_GRAMMAR_FIXTURE_H
@@ -0,0 +1,126 @@
+/**
+ * @file test10.cpp
+ * @brief 测试 SeuLex 的流式输入：词法单元跨越缓冲区边界、超过缓冲区容量时的结果与整块输入一致
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::SeuLex;
+using namespace std;
+
+/**
+ * 每次 underflow 只给出一段数据，模拟终端或管道：后面的数据要等下一次读取才到达
+ */
+class ChunkBuf : public streambuf {
+ public:
+  explicit ChunkBuf(vector<string> chunks) : chunks_(move(chunks)) {}
+
+  size_t reads_ = 0;
+
+ protected:
+  int_type underflow() override {
+    if (next_ == chunks_.size())
+      return traits_type::eof();
+    ++reads_;
+    auto &chunk = chunks_[next_++];
+    setg(chunk.data(), chunk.data(), chunk.data() + chunk.size());
+    return traits_type::to_int_type(chunk[0]);
+  }
+
+ private:
+  vector<string> chunks_;
+
+  size_t next_ = 0;
+};
+
+vector<string> regex_strings = {
+    R"((int))",
+    R"([0-9]+)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"("[^"]*")",
+    R"(;)",
+    R"(=)",
+    R"(( |\t|\n|\r))",
+};
+
+vector<tuple<int, string, int, int>> scan(SeuLex &lexer) {
+  vector<tuple<int, string, int, int>> result;
+  while (true) {
+    auto lexeme = lexer.Lex();
+    if (lexeme.rule < 0) break;
+    auto [row, col] = lexer.Locate(lexeme.offset);
+    result.emplace_back(lexeme.rule, string(lexer.Text(lexeme)), row, col);
+  }
+  return result;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  SeuLex lexer(transition, accept, tokens, Token::Terminator("end"));
+
+  string text;
+  for (int i = 0; i < 500; ++i) {
+    text += "int x" + to_string(i) + " = " + to_string(i * 7919) + ";\n";
+    if (i % 100 == 0) {
+      // 超过缓冲区容量的词法单元
+      text += "\"" + string(100, 'a') + "\";\n";
+    }
+  }
+  lexer.SetInput(text);
+  auto expect = scan(lexer);
+
+  for (size_t capacity : {1, 7, 16, 64, 4096}) {
+    istringstream iss(text);
+    lexer.SetIn(&iss, capacity);
+    auto result = scan(lexer);
+    cout << boolalpha << "capacity=" << capacity << ": " << (result == expect)
+         << endl;
+  }
+
+  // input / unput 跨越缓冲区边界
+  istringstream iss("int abc");
+  lexer.SetIn(&iss, 3);
+  lexer.Lex();
+  string rest;
+  for (char c = lexer.Input(); c != 0; c = lexer.Input()) rest.push_back(c);
+  lexer.Unput('c');
+  cout << "input/unput: " << (rest == " abc" && lexer.Input() == 'c') << endl;
+
+  // 退回与读到的不同的字符，跨越缓冲区边界
+  istringstream other("int x;");
+  lexer.SetIn(&other, 3);
+  lexer.Lex();
+  lexer.Input();
+  lexer.Input();
+  lexer.Unput('z');
+  lexer.Unput('_');
+  auto lexeme = lexer.Lex();
+  cout << "unput other: " << (lexer.Text(lexeme) == "_z") << endl;
+
+  // 交互式输入：第一段到达后就能得到词法单元，不等待缓冲区读满
+  ChunkBuf chunks({"int x = 1;\n", "y = 2;\n"});
+  istream interactive(&chunks);
+  lexer.SetIn(&interactive, 4096);
+  auto first = lexer.Lex();
+  bool short_read = first.rule == 0 && chunks.reads_ == 1;
+  auto rest_tokens = scan(lexer);
+  cout << "short read: "
+       << (short_read && rest_tokens.size() == 15 && chunks.reads_ == 2) << endl;
+  return 0;
+}
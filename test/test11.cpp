@@ -0,0 +1,72 @@
+/**
+ * @file test11.cpp
+ * @brief 测试最长匹配：较长前缀失败时回退到最后一个接受位置
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "sly/Stream2TokenPipe.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::SeuLex;
+using sly::runtime::Stream2TokenPipe;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"([0-9]+)",
+    R"([0-9]+\.[0-9]+(e[0-9]+)?)",
+    R"(\.\.\.)",
+    R"(\.)",
+    R"([a-z]+)",
+    R"(( |\n))",
+};
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+
+  string text = "1.e .. ... 1.5e3 2.5e x..";
+  vector<string> expect = {"1", ".", "e", " ", ".", ".", " ", "...", " ",
+                           "1.5e3", " ", "2.5", "e", " ", "x", ".", "."};
+
+  SeuLex lexer(transition, accept, tokens, end_token);
+  lexer.SetInput(text);
+  lexer.Process();
+  vector<string> result;
+  for (const auto &lexeme : lexer.GetLexemes()) {
+    result.emplace_back(lexer.Text(lexeme));
+  }
+  cout << boolalpha << "SeuLex: " << (result == expect) << endl;
+
+  // 流式输入，回退跨越缓冲区边界
+  istringstream iss1(text);
+  lexer.SetIn(&iss1, 2);
+  result.clear();
+  for (auto lexeme = lexer.Lex(); lexeme.rule >= 0; lexeme = lexer.Lex()) {
+    result.emplace_back(lexer.Text(lexeme));
+  }
+  cout << "SeuLex (stream): " << (result == expect) << endl;
+
+  Stream2TokenPipe s2ppl(transition, accept, tokens, end_token);
+  istringstream iss2(text);
+  result.clear();
+  while (s2ppl.Defer(iss2) != end_token) {
+    result.push_back(s2ppl.buffer_);
+  }
+  cout << "Stream2TokenPipe: " << (result == expect) << endl;
+  return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file test12.cpp
+ * @brief 测试词法 -> 语法的传递过程中（AttrDict::SetLexeme、yytext 视图）没有逐个词法单元的堆分配
+ */
+
+#include "sly/AttrDict.h"
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::core::type::AttrDict;
+using sly::runtime::SeuLex;
+using sly::runtime::TextView;
+using namespace std;
+
+static size_t allocation_count = 0;
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *p = malloc(size)) return p;
+  throw bad_alloc();
+}
+
+/**
+ * 不内联：内联后编译器会把 free 与调用方的 new 表达式配对，报
+ * -Wmismatched-new-delete
+ */
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+
+vector<string> regex_strings = {
+    R"([0-9]+)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"(=)",
+    R"(;)",
+    R"(( |\n))",
+};
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+  }
+  tokens = {Token::Terminator("NUM"), Token::Terminator("ID"),
+            Token::Terminator("="), Token::Terminator(";"),
+            Token::Terminator("WS")};
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+
+  string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += "variable_" + to_string(i) + " = " + to_string(i * 31) + ";\n";
+  }
+  SeuLex lexer(transition, accept, tokens, end_token);
+  lexer.SetInput(text);
+
+  vector<Token> syntax_tokens;
+  vector<AttrDict> attributes;
+  syntax_tokens.reserve(text.size());
+  attributes.reserve(text.size());
+  TextView yytext;
+  size_t before = allocation_count;
+  while (true) {
+    auto lexeme = lexer.Lex();
+    const auto &token = lexer.GetToken(lexeme);
+    AttrDict ad;
+    ad.SetLexeme(lexer.Text(lexeme), lexeme.offset, &lexer);
+    yytext = lexer.Text(lexeme);
+    syntax_tokens.emplace_back(token);
+    attributes.emplace_back(std::move(ad));
+    if (token == end_token) break;
+  }
+  size_t allocations = allocation_count - before;
+
+  cout << boolalpha << "tokens: " << attributes.size()
+       << ", allocations: " << allocations << " " << (allocations == 0) << endl;
+  const auto &ad = attributes[7];
+  cout << "inline attrs: "
+       << (ad.Get<string>("lval") == "variable_1" && ad.Get<int>("row") == 2 &&
+           ad.Get<int>("col") == 1)
+       << endl;
+  cout << "yytext sentinel: " << (yytext.empty() && yytext[0] == '\0') << endl;
+  return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file test13.cpp
+ * @brief 测试 SeuLex::LexBatch 与逐个调用 Lex 的结果一致，并比较吞吐量
+ */
+
+#include "sly/AttrDict.h"
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::core::type::AttrDict;
+using sly::core::type::SourceLocation;
+using sly::runtime::SeuLex;
+using sly::runtime::TokenBatch;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((int))",
+    R"((return))",
+    R"([0-9]+)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"(L?"(\\.|[^\\"\n\r])*")",
+    R"(;)",
+    R"(\()",
+    R"(\))",
+    R"(\{)",
+    R"(\})",
+    R"(,)",
+    R"(=)",
+    R"(\+)",
+    R"(( |\t|\n|\r))",
+};
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+
+  string text;
+  for (int i = 0; i < 20000; ++i) {
+    text += "int main() {\n  printf(\"Hello World!\", " + to_string(i) +
+            ");\n  return x1 + 0;\n}\n";
+  }
+  SeuLex lexer(transition, accept, tokens, end_token);
+  using ms = chrono::duration<double, milli>;
+
+  // 逐个词法单元：Token + AttrDict
+  lexer.SetInput(text);
+  vector<Token> pulled_tokens;
+  vector<AttrDict> pulled_attrs;
+  auto t0 = chrono::steady_clock::now();
+  while (true) {
+    auto lexeme = lexer.Lex();
+    if (lexeme.rule < 0) break;
+    AttrDict ad;
+    ad.SetLexeme(lexer.Text(lexeme), lexeme.offset, &lexer);
+    pulled_tokens.push_back(lexer.GetToken(lexeme));
+    pulled_attrs.push_back(move(ad));
+  }
+  auto t1 = chrono::steady_clock::now();
+
+  // 批量
+  constexpr size_t kBatch = 4096;
+  vector<int> rules(kBatch);
+  vector<size_t> offsets(kBatch);
+  vector<uint32_t> lengths(kBatch);
+  vector<SourceLocation> locations(kBatch);
+  TokenBatch batch{rules.data(), offsets.data(), lengths.data(),
+                   locations.data(), kBatch};
+  // 逐个词法单元的行列号在比较时才求出，批量扫描使用另一个扫描器，不切换 lexer 的输入
+  SeuLex batch_lexer(transition, accept, tokens, end_token);
+  batch_lexer.SetInput(text);
+  size_t total = 0;
+  bool same = true;
+  auto t2 = chrono::steady_clock::now();
+  for (size_t n = batch_lexer.LexBatch(batch); n > 0;
+       n = batch_lexer.LexBatch(batch)) {
+    for (size_t i = 0; i < n && same; ++i) {
+      const auto &ad = pulled_attrs[total + i];
+      same = pulled_tokens[total + i] == tokens[rules[i]] &&
+             ad.GetLexeme() == text.substr(offsets[i], lengths[i]) &&
+             ad.GetLocation().row == locations[i].row &&
+             ad.GetLocation().col == locations[i].col;
+    }
+    total += n;
+  }
+  auto t3 = chrono::steady_clock::now();
+  same = same && total == pulled_tokens.size();
+  cout << boolalpha << "batch equal: " << same << " (" << total << " tokens)"
+       << endl;
+
+  // ToStrDict 打印的行列号同样按需求出：第二行的 printf 位于 2:3
+  AttrDict lazy;
+  lazy.SetLexeme("printf", text.find("printf"), &lexer);
+  auto dict = lazy.ToStrDict();
+  cout << "lazy location in ToStrDict: " << (dict["row"] == "2" && dict["col"] == "3")
+       << endl;
+
+  // 仅计时的批量扫描
+  batch_lexer.SetInput(text);
+  auto t4 = chrono::steady_clock::now();
+  total = 0;
+  for (size_t n = batch_lexer.LexBatch(batch); n > 0;
+       n = batch_lexer.LexBatch(batch)) {
+    total += n;
+  }
+  auto t5 = chrono::steady_clock::now();
+
+  cout << "pull (Token + AttrDict): " << ms(t1 - t0).count() << " ms" << endl;
+  cout << "batch (with check):      " << ms(t3 - t2).count() << " ms" << endl;
+  cout << "batch:                   " << ms(t5 - t4).count() << " ms" << endl;
+  return 0;
+}
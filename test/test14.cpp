@@ -0,0 +1,89 @@
+/**
+ * @file test14.cpp
+ * @brief 测试 SeuLex::ParallelProcess 与 Process 的结果一致（含跨越换行的词法单元），并比较耗时
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::Lexeme;
+using sly::runtime::SeuLex;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((int))",
+    R"((return))",
+    R"([0-9]+)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    // 字符串可以跨行，块的推测起点可能落在字符串内部
+    R"("[^"]*")",
+    R"(;)",
+    R"(\()",
+    R"(\))",
+    R"(\{)",
+    R"(\})",
+    R"(,)",
+    R"(=)",
+    R"(\+)",
+    R"(( |\t|\n|\r))",
+};
+
+bool equal(const vector<Lexeme> &a, const vector<Lexeme> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].rule != b[i].rule || a[i].offset != b[i].offset ||
+        a[i].length != b[i].length)
+      return false;
+  }
+  return true;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  SeuLex lexer(transition, accept, tokens, Token::Terminator("end"));
+
+  string text;
+  for (int i = 0; i < 60000; ++i) {
+    text += "int main() {\n  printf(\"Hello World!\", " + to_string(i) +
+            ");\n  return x1 + 0;\n}\n";
+    if (i % 97 == 0) {
+      text += "\"multi\nline\nstring\n int x = 1;\n\"\n";
+    }
+  }
+
+  using ms = chrono::duration<double, milli>;
+  lexer.SetInput(text);
+  auto t0 = chrono::steady_clock::now();
+  lexer.Process();
+  auto t1 = chrono::steady_clock::now();
+  auto expect = lexer.GetLexemes();
+  cout << "sequential: " << ms(t1 - t0).count() << " ms (" << expect.size()
+       << " tokens, " << thread::hardware_concurrency() << " cores)" << endl;
+
+  for (size_t threads : {2, 3, 8, 16}) {
+    lexer.SetInput(text);
+    auto t2 = chrono::steady_clock::now();
+    lexer.ParallelProcess(threads);
+    auto t3 = chrono::steady_clock::now();
+    cout << boolalpha << "threads=" << threads << ": "
+         << equal(lexer.GetLexemes(), expect) << " " << ms(t3 - t2).count()
+         << " ms" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file test15.cpp
+ * @brief 测试 SeuLex::Relex：随机编辑后增量扫描的结果与重新扫描整个输入一致
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::Lexeme;
+using sly::runtime::SeuLex;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((int))",
+    R"([0-9]+)",
+    R"([0-9]+\.[0-9]+(e[0-9]+)?)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"("[^"]*")",
+    R"(\.\.\.)",
+    R"(\.)",
+    R"(;)",
+    R"(=)",
+    R"(( |\n))",
+};
+
+bool equal(const vector<Lexeme> &a, const vector<Lexeme> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].rule != b[i].rule || a[i].offset != b[i].offset ||
+        a[i].length != b[i].length)
+      return false;
+  }
+  return true;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  SeuLex lexer(transition, accept, tokens, Token::Terminator("end"));
+  SeuLex reference(transition, accept, tokens, Token::Terminator("end"));
+
+  string text;
+  for (int i = 0; i < 300; ++i) {
+    text += "int x" + to_string(i) + " = " + to_string(i) + ".5e1;\n";
+  }
+  lexer.SetInput(text);
+  lexer.Process();
+
+  // 编辑的片段可能与前后文合并（如 "1" 接在数字后）或打开/关闭字符串
+  vector<string> snippets = {"", "1", ".", "..", "e", "x", " ", "\n", "\"",
+                             "int", ";", "2.5", "abc def"};
+  mt19937 rng(20220330);
+  bool all_same = true;
+  size_t rescanned = 0;
+  size_t applied_edits = 0;
+  for (int i = 0; i < 2000 && all_same; ++i) {
+    size_t offset = rng() % (text.size() + 1);
+    size_t deleted = min<size_t>(rng() % 4, text.size() - offset);
+    const string &snippet = snippets[rng() % snippets.size()];
+    // 字符串未闭合时输入中会出现词法错误，跳过这样的编辑
+    string edited = text;
+    edited.replace(offset, deleted, snippet);
+    if (count(edited.begin(), edited.end(), '"') % 2 != 0) continue;
+
+    auto old = lexer.GetLexemes();
+    auto diff = lexer.Relex(offset, deleted, snippet);
+    text = edited;
+    rescanned += diff.inserted.size();
+    applied_edits += 1;
+
+    // 把 diff 应用到旧数组上，应当得到新的结果
+    vector<Lexeme> applied(old.begin(), old.begin() + diff.first);
+    applied.insert(applied.end(), diff.inserted.begin(), diff.inserted.end());
+    for (size_t j = diff.first + diff.removed; j < old.size(); ++j) {
+      applied.push_back({old[j].rule,
+                         static_cast<size_t>(static_cast<ptrdiff_t>(old[j].offset) + diff.shift),
+                         old[j].length});
+    }
+    reference.SetInput(text);
+    reference.Process();
+    all_same = equal(lexer.GetLexemes(), reference.GetLexemes()) &&
+               equal(applied, reference.GetLexemes());
+  }
+  cout << boolalpha << "relex equal: " << all_same << endl;
+  cout << "average rescanned tokens per edit: "
+       << static_cast<double>(rescanned) / applied_edits << " of "
+       << lexer.GetLexemes().size() << endl;
+  return 0;
+}
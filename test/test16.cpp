@@ -0,0 +1,116 @@
+/**
+ * @file test16.cpp
+ * @brief 测试 LineIndex 的行列号与逐字节计算一致（含制表符、分段建立索引与截断），
+ * 以及 SeuLex 与 Stream2TokenPipe 在 CRLF 输入上给出相同的行列号
+ */
+
+#include "sly/FaModel.h"
+#include "sly/LineIndex.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "sly/Stream2TokenPipe.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::core::type::SourceLocation;
+using sly::runtime::LineIndex;
+using sly::runtime::SeuLex;
+using sly::runtime::Stream2TokenPipe;
+using namespace std;
+
+vector<SourceLocation> naive(const string &text) {
+  vector<SourceLocation> result;
+  uint32_t row = 1, col = 1;
+  for (char c : text) {
+    result.push_back({row, col});
+    if (c == '\n') {
+      row += 1;
+      col = 1;
+    } else if (c == '\t') {
+      col += 8 - ((col - 1) % 8);
+    } else {
+      col += 1;
+    }
+  }
+  result.push_back({row, col});
+  return result;
+}
+
+bool check(const LineIndex &index, const vector<SourceLocation> &expect,
+           size_t limit) {
+  for (size_t i = 0; i <= limit; ++i) {
+    auto loc = index.Locate(i);
+    if (loc.row != expect[i].row || loc.col != expect[i].col) return false;
+  }
+  return true;
+}
+
+int main() {
+  mt19937 rng(20220330);
+  const string alphabet = "abc \t\n\r;";
+  string text;
+  for (int i = 0; i < 5000; ++i) {
+    text.push_back(alphabet[rng() % alphabet.size()]);
+  }
+  auto expect = naive(text);
+
+  // 一次建立
+  LineIndex whole;
+  whole.Extend(text.data(), text.size());
+  cout << boolalpha << "whole: " << check(whole, expect, text.size()) << endl;
+
+  // 分段建立，段长不对齐 16 字节
+  LineIndex pieces;
+  for (size_t i = 0; i < text.size();) {
+    size_t n = min<size_t>(1 + rng() % 37, text.size() - i);
+    pieces.Extend(text.data() + i, n);
+    i += n;
+  }
+  cout << "pieces: " << check(pieces, expect, text.size()) << endl;
+
+  // 截断后重新建立修改过的部分
+  string edited = text.substr(0, 2500) + "\t\tx\ny\t" + text.substr(2600);
+  whole.Truncate(2500);
+  whole.Extend(edited.data() + 2500, edited.size() - 2500);
+  cout << "truncate: " << check(whole, naive(edited), edited.size()) << endl;
+
+  // CRLF 输入：两种扫描器的行列号都与逐字节计算一致
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : {R"([a-z]+)", R"(( |\t|\n|\r))"}) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  string crlf;
+  for (int i = 0; i < 200; ++i) {
+    crlf += string(1 + rng() % 5, 'a' + rng() % 26);
+    crlf += " \t\r\n"[rng() % 4];
+    if (rng() % 4 == 0)
+      crlf += "\r\n";
+  }
+  auto crlf_expect = naive(crlf);
+  SeuLex lexer(transition, accept, tokens, end_token);
+  lexer.SetInput(crlf);
+  Stream2TokenPipe pipe(transition, accept, tokens, end_token);
+  istringstream iss(crlf);
+  bool same = true;
+  for (auto lexeme = lexer.Lex(); lexeme.rule >= 0; lexeme = lexer.Lex()) {
+    auto loc = lexer.Locate(lexeme.offset);
+    pipe.Defer(iss);
+    same = same && loc.row == crlf_expect[lexeme.offset].row &&
+           loc.col == crlf_expect[lexeme.offset].col &&
+           pipe.token_begin_row_ == static_cast<int>(loc.row) &&
+           pipe.token_begin_col_ == static_cast<int>(loc.col);
+  }
+  cout << "crlf: " << same << endl;
+  return 0;
+}
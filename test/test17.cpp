@@ -0,0 +1,115 @@
+/**
+ * @file test17.cpp
+ * @brief 测试起始条件：每个条件使用只含自身规则的状态转移表，BEGIN 切换后按新表扫描
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::SeuLex;
+using namespace std;
+
+#define INITIAL 0
+#define COMMENT 1
+
+vector<string> regex_strings = {
+    R"(/\*)",     // INITIAL
+    R"([a-z]+)",  // INITIAL
+    R"(( |\n)+)", // INITIAL
+    R"(\*/)",     // COMMENT
+    R"([^\*]+)",  // COMMENT
+    R"(\*)",      // COMMENT
+};
+
+vector<vector<int>> condition_rules = {{0, 1, 2}, {3, 4, 5}};
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+
+  SeuLex lexer;
+  size_t merged_size = DfaModel::Merge(dfa_list).first.size();
+  size_t condition_size = 0;
+  for (size_t condition = 0; condition < condition_rules.size(); ++condition) {
+    vector<DfaModel> rules;
+    for (int rule : condition_rules[condition]) {
+      rules.push_back(dfa_list[rule]);
+    }
+    auto [transition, accept] = DfaModel::Merge(rules);
+    for (auto &rule : accept) {
+      if (rule >= 0)
+        rule = condition_rules[condition][rule];
+    }
+    condition_size = max(condition_size, transition.size());
+    if (condition == INITIAL)
+      lexer = SeuLex(transition, accept, tokens, end_token);
+    else
+      cout << boolalpha << "condition id: " << (lexer.AddCondition(transition, accept) == COMMENT) << endl;
+  }
+  cout << "compact: " << (condition_size < merged_size) << endl;
+
+  // 同样的字符在注释内外属于不同的规则
+  string text = "ab /* x * y */ cd/**/e";
+  vector<pair<int, string>> expect = {
+      {1, "ab"}, {2, " "}, {0, "/*"}, {4, " x "}, {5, "*"}, {4, " y "},
+      {3, "*/"}, {2, " "}, {1, "cd"}, {0, "/*"}, {3, "*/"}, {1, "e"}};
+  lexer.SetInput(text);
+  vector<pair<int, string>> result;
+  for (auto lexeme = lexer.Lex(); lexeme.rule >= 0; lexeme = lexer.Lex()) {
+    result.emplace_back(lexeme.rule, lexer.Text(lexeme));
+    if (lexeme.rule == 0)
+      lexer.Begin(COMMENT);
+    else if (lexeme.rule == 3)
+      lexer.Begin(INITIAL);
+  }
+  cout << "conditions: " << (result == expect) << endl;
+  cout << "current: " << (lexer.GetCondition() == INITIAL) << endl;
+
+  // 流式输入时切换条件同样有效
+  istringstream iss(text);
+  lexer.SetIn(&iss, 3);
+  result.clear();
+  for (auto lexeme = lexer.Lex(); lexeme.rule >= 0; lexeme = lexer.Lex()) {
+    result.emplace_back(lexeme.rule, lexer.Text(lexeme));
+    lexer.Begin(lexeme.rule == 0 ? COMMENT : lexeme.rule == 3 ? INITIAL : lexer.GetCondition());
+  }
+  cout << "stream: " << (result == expect) << endl;
+
+  // 未定义的条件
+  bool thrown = false;
+  try {
+    lexer.Begin(2);
+  } catch (const runtime_error &) {
+    thrown = true;
+  }
+  cout << "undefined: " << thrown << endl;
+
+  // 接受状态的规则编号越界时拒绝添加，已有的条件不变
+  thrown = false;
+  try {
+    lexer.AddCondition({{}}, {static_cast<int>(tokens.size())});
+  } catch (const runtime_error &) {
+    thrown = true;
+  }
+  try {
+    lexer.Begin(2);
+    thrown = false;
+  } catch (const runtime_error &) {
+  }
+  cout << "bad accept rejected: " << thrown << endl;
+  return 0;
+}
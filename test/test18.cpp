@@ -0,0 +1,144 @@
+/**
+ * @file test18.cpp
+ * @brief 测试关键字表：关键字规则不进入 DFA 时识别结果不变，比较状态数与扫描耗时
+ */
+
+#include "sly/FaModel.h"
+#include "sly/KeywordTable.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::KeywordTable;
+using sly::runtime::SeuLex;
+using namespace std;
+
+vector<string> keywords = {
+    "auto", "_Bool", "break", "case", "char", "_Complex", "const", "continue",
+    "default", "do", "double", "else", "enum", "extern", "float", "for", "goto",
+    "if", "_Imaginary", "inline", "int", "long", "register", "restrict",
+    "return", "short", "signed", "sizeof", "static", "struct", "switch",
+    "typedef", "union", "unsigned", "void", "volatile", "while"};
+
+vector<string> other_rules = {
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"([0-9]+)",
+    R"((\.\.\.))",
+    R"((>>=))",
+    R"((<<=))",
+    R"((\+=))",
+    R"((\->))",
+    R"((\+\+))",
+    R"((<=))",
+    R"((==))",
+    R"(;)",
+    R"(\()",
+    R"(\))",
+    R"(\{)",
+    R"(\})",
+    R"(,)",
+    R"(=)",
+    R"(\+)",
+    R"(\-)",
+    R"(<)",
+    R"(>)",
+    R"(\.)",
+    R"(( |\t|\n|\r))",
+};
+
+double scan(SeuLex &lexer, const string &text, vector<pair<int, size_t>> &result) {
+  lexer.SetInput(text);
+  result.clear();
+  auto t0 = chrono::steady_clock::now();
+  lexer.Process();
+  auto t1 = chrono::steady_clock::now();
+  for (const auto &lexeme : lexer.GetLexemes()) {
+    result.emplace_back(lexeme.rule, lexeme.length);
+  }
+  return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  // 与 c99.l 相同，关键字规则在标识符规则之前；"do" 同时是 "double" 的前缀
+  for (const auto &k : keywords) {
+    dfa_list.push_back(RegEx("(" + k + ")").GetDfaModel());
+    tokens.push_back(Token::Terminator(k));
+  }
+  for (const auto &r : other_rules) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+
+  auto [full_transition, full_accept] = DfaModel::Merge(dfa_list);
+  SeuLex full(full_transition, full_accept, tokens, end_token);
+
+  vector<int> rules(dfa_list.size());
+  iota(rules.begin(), rules.end(), 0);
+  auto [kept, table] = KeywordTable::Extract(dfa_list, rules);
+  vector<DfaModel> kept_dfa;
+  for (int rule : kept) {
+    kept_dfa.push_back(dfa_list[rule]);
+  }
+  auto [transition, accept] = DfaModel::Merge(kept_dfa);
+  for (auto &rule : accept) {
+    if (rule >= 0)
+      rule = kept[rule];
+  }
+  SeuLex lexer(tokens, end_token);
+  lexer.AddCondition(transition, accept, table);
+
+  cout << boolalpha << "extracted: " << (table.Size() == keywords.size()) << endl;
+  bool found = true;
+  for (int i = 0; i < static_cast<int>(keywords.size()); ++i) {
+    found = found && table.Find(keywords[i].data(), keywords[i].size()) == i;
+  }
+  cout << "find: " << (found && table.Find("dou", 3) < 0 && table.Find("whiles", 6) < 0) << endl;
+  bool rejected = false;
+  try {
+    KeywordTable({{"if", 0}, {"else", 1}, {"if", 2}});
+  } catch (const runtime_error &) {
+    rejected = true;
+  }
+  cout << "duplicate rejected: " << rejected << endl;
+  cout << "states: " << full_transition.size() << " -> " << transition.size() << endl;
+
+  // 关键字、关键字的前缀与扩展、其他标识符混合
+  mt19937 rng(20220330);
+  vector<string> words = keywords;
+  for (const auto &k : keywords) {
+    words.push_back(k + "x");
+    words.push_back(k.substr(0, k.size() - 1));
+  }
+  for (string w : {"x1", "main", "printf", "0", "42", "...", ">>=", "->", "++",
+                   "<=", "==", ";", "(", ")", "{", "}", "=", "+", ".", "<"}) {
+    words.push_back(w);
+  }
+  string text;
+  while (text.size() < 4 * 1024 * 1024) {
+    text += words[rng() % words.size()];
+    text += " \n\t"[rng() % 3];
+  }
+
+  vector<pair<int, size_t>> expect, result;
+  double full_ms = 1e9, keyword_ms = 1e9;
+  for (int round = 0; round < 3; ++round) {
+    full_ms = min(full_ms, scan(full, text, expect));
+    keyword_ms = min(keyword_ms, scan(lexer, text, result));
+  }
+  cout << "tokens equal: " << (result == expect) << " (" << result.size() << " tokens)" << endl;
+  cout << "full table:    " << full_ms << " ms" << endl;
+  cout << "keyword table: " << keyword_ms << " ms" << endl;
+  return 0;
+}
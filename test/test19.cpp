@@ -0,0 +1,153 @@
+/**
+ * @file test19.cpp
+ * @brief 测试各扫描循环（单字节、展开、双字节步长）结果相同，并比较吞吐量
+ */
+
+#include "sly/FaModel.h"
+#include "sly/KeywordTable.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::KeywordTable;
+using sly::runtime::ScanLoop;
+using sly::runtime::SeuLex;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((auto))", R"((break))", R"((case))", R"((char))", R"((const))",
+    R"((continue))", R"((default))", R"((do))", R"((double))", R"((else))",
+    R"((enum))", R"((extern))", R"((float))", R"((for))", R"((goto))",
+    R"((if))", R"((int))", R"((long))", R"((return))", R"((short))",
+    R"((signed))", R"((sizeof))", R"((static))", R"((struct))", R"((switch))",
+    R"((typedef))", R"((union))", R"((unsigned))", R"((void))", R"((while))",
+    R"(//[^\n]*)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"(0[xX][a-fA-F0-9]+)",
+    R"([0-9]+)",
+    R"([0-9]+\.[0-9]+([Ee][+\-]?[0-9]+)?)",
+    R"(L?"(\\.|[^\\"\n\r])*")",
+    R"((\.\.\.))", R"((>>=))", R"((<<=))", R"((\+=))", R"((\-=))",
+    R"((\->))", R"((\+\+))", R"((\-\-))", R"((&&))", R"((\|\|))",
+    R"((<=))", R"((>=))", R"((==))", R"((!=))",
+    R"(;)", R"(\{)", R"(\})", R"(,)", R"(:)", R"(=)", R"(\()", R"(\))",
+    R"(\[)", R"(\])", R"(\.)", R"(&)", R"(!)", R"(~)", R"(\-)", R"(\+)",
+    R"(\*)", R"(/)", R"(%)", R"(<)", R"(>)", R"(\^)", R"(\|)", R"(\?)",
+    R"(( |\t|\n|\r)+)",
+};
+
+vector<ScanLoop> loops = {ScanLoop::kByte, ScanLoop::kUnrolled, ScanLoop::kStride2};
+vector<string> loop_names = {"byte", "unrolled", "stride2"};
+
+double scan(SeuLex &lexer, const string &text, vector<pair<int, size_t>> &result) {
+  lexer.SetInput(text);
+  auto t0 = chrono::steady_clock::now();
+  lexer.Process();
+  auto t1 = chrono::steady_clock::now();
+  result.clear();
+  for (const auto &lexeme : lexer.GetLexemes()) {
+    result.emplace_back(lexeme.rule, lexeme.length);
+  }
+  return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+
+  // 完整的表与去掉关键字后的表
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  SeuLex full(transition, accept, tokens, end_token);
+  vector<int> rules(dfa_list.size());
+  iota(rules.begin(), rules.end(), 0);
+  auto [kept, keywords] = KeywordTable::Extract(dfa_list, rules);
+  vector<DfaModel> kept_dfa;
+  for (int rule : kept) {
+    kept_dfa.push_back(dfa_list[rule]);
+  }
+  auto [small_transition, small_accept] = DfaModel::Merge(kept_dfa);
+  for (auto &rule : small_accept) {
+    if (rule >= 0)
+      rule = kept[rule];
+  }
+  SeuLex small(tokens, end_token);
+  small.AddCondition(small_transition, small_accept, keywords);
+  cout << "states: full " << transition.size() << ", keyword table " << small_transition.size() << endl;
+
+  mt19937 rng(20220330);
+  stringstream ss;
+  for (int i = 0; ss.tellp() < 8 * 1024 * 1024; ++i) {
+    ss << "static int f" << i << "(const char *s, unsigned long n) {\n"
+       << "  // loop " << rng() % 1000 << "\n"
+       << "  for (int i = 0; i < n && s[i] != 0x" << hex << rng() % 4096 << dec << "; ++i) {\n"
+       << "    total += s[i] * " << rng() % 100 << "." << rng() % 100 << "e-3;\n"
+       << "    if (total >= limit) return printf(\"overflow %d\\n\", i);\n"
+       << "  }\n  return total->value;\n}\n\n";
+  }
+  string text = ss.str();
+
+  // 词法单元较长的输入：注释与字符串常量
+  stringstream ls;
+  while (ls.tellp() < 8 * 1024 * 1024) {
+    ls << "// ";
+    for (int j = 0; j < 60; ++j) {
+      ls << static_cast<char>('a' + rng() % 26) << (rng() % 6 == 0 ? " " : "");
+    }
+    ls << "\nputs(\"";
+    for (int j = 0; j < 60; ++j) {
+      ls << static_cast<char>('A' + rng() % 26) << (rng() % 6 == 0 ? ", " : "");
+    }
+    ls << "\");\n";
+  }
+  string long_text = ls.str();
+
+  bool equal = true;
+  for (auto *lexer : {&full, &small}) {
+    vector<pair<int, size_t>> expect, result;
+    cout << (lexer == &full ? "full table:" : "keyword table:") << endl;
+    for (const auto *corpus : {&long_text, &text}) {
+      for (size_t i = 0; i < loops.size(); ++i) {
+        lexer->SetScanLoop(loops[i]);
+        double best = 1e9;
+        for (int round = 0; round < 3; ++round) {
+          best = min(best, scan(*lexer, *corpus, i == 0 ? expect : result));
+        }
+        if (i > 0)
+          equal = equal && result == expect;
+        cout << "  " << (corpus == &text ? "c code, " : "long lexemes, ")
+             << loop_names[i] << ": " << best << " ms" << endl;
+      }
+    }
+
+    // 流式输入，缓冲区很小时转移跨越补充边界
+    for (size_t i = 0; i < loops.size(); ++i) {
+      lexer->SetScanLoop(loops[i]);
+      istringstream iss(text.substr(0, 64 * 1024));
+      lexer->SetIn(&iss, 7);
+      vector<pair<int, size_t>> streamed;
+      for (auto lexeme = lexer->Lex(); lexeme.rule >= 0; lexeme = lexer->Lex()) {
+        streamed.emplace_back(lexeme.rule, lexeme.length);
+      }
+      // 截断处的最后一个词法单元可能不同
+      equal = equal && streamed.size() > 1 &&
+              std::equal(streamed.begin(), streamed.end() - 1, expect.begin());
+    }
+  }
+  cout << boolalpha << "tokens equal: " << equal << endl;
+  return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file test20.cpp
+ * @brief 测试按剖析结果重新编号状态：识别结果不变，热点行集中，保存与读入后结果相同
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::SeuLex;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((auto))", R"((break))", R"((case))", R"((char))", R"((const))",
+    R"((continue))", R"((default))", R"((do))", R"((double))", R"((else))",
+    R"((enum))", R"((extern))", R"((float))", R"((for))", R"((goto))",
+    R"((if))", R"((int))", R"((long))", R"((return))", R"((short))",
+    R"((signed))", R"((sizeof))", R"((static))", R"((struct))", R"((switch))",
+    R"((typedef))", R"((union))", R"((unsigned))", R"((void))", R"((while))",
+    R"(//[^\n]*)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"(0[xX][a-fA-F0-9]+)",
+    R"([0-9]+)",
+    R"([0-9]+\.[0-9]+([Ee][+\-]?[0-9]+)?)",
+    R"(L?"(\\.|[^\\"\n\r])*")",
+    R"((\->))", R"((\+\+))", R"((<=))", R"((>=))", R"((==))", R"((!=))", R"((&&))",
+    R"(;)", R"(\{)", R"(\})", R"(,)", R"(=)", R"(\()", R"(\))",
+    R"(\[)", R"(\])", R"(\.)", R"(\-)", R"(\+)", R"(\*)", R"(<)", R"(>)",
+    R"(( |\t|\n|\r)+)",
+};
+
+vector<pair<int, size_t>> scan(SeuLex &lexer, const string &text, double &ms) {
+  lexer.SetInput(text);
+  auto t0 = chrono::steady_clock::now();
+  lexer.Process();
+  auto t1 = chrono::steady_clock::now();
+  ms = min(ms, chrono::duration<double, milli>(t1 - t0).count());
+  vector<pair<int, size_t>> result;
+  for (const auto &lexeme : lexer.GetLexemes()) {
+    result.emplace_back(lexeme.rule, lexeme.length);
+  }
+  return result;
+}
+
+// 占 99% 访问次数的最少的行中，最大的状态编号
+size_t hot_span(const vector<uint64_t> &visits) {
+  uint64_t total = accumulate(visits.begin(), visits.end(), uint64_t(0));
+  vector<int> order(visits.size());
+  iota(order.begin(), order.end(), 0);
+  sort(order.begin(), order.end(), [&](int a, int b) { return visits[a] > visits[b]; });
+  uint64_t sum = 0;
+  size_t span = 0;
+  for (int s : order) {
+    if (sum >= total * 99 / 100)
+      break;
+    sum += visits[s];
+    span = max(span, static_cast<size_t>(s) + 1);
+  }
+  return span;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  SeuLex lexer(transition, accept, tokens, end_token);
+
+  mt19937 rng(20220330);
+  auto corpus = [&rng](size_t size) {
+    stringstream ss;
+    for (int i = 0; ss.tellp() < static_cast<streamoff>(size); ++i) {
+      ss << "static int f" << i << "(const char *s, unsigned long n) {\n"
+         << "  // loop " << rng() % 1000 << "\n"
+         << "  for (int i = 0; i < n && s[i] != 0x" << hex << rng() % 4096 << dec << "; ++i) {\n"
+         << "    total += s[i] * " << rng() % 100 << "." << rng() % 100 << "e-3;\n"
+         << "    if (total >= limit) return printf(\"overflow %d\\n\", i);\n"
+         << "  }\n  return total->value;\n}\n\n";
+    }
+    return ss.str();
+  };
+  string sample = corpus(256 * 1024);
+  string text = corpus(8 * 1024 * 1024);
+
+  double before_ms = 1e9, after_ms = 1e9, loaded_ms = 1e9;
+  auto expect = scan(lexer, text, before_ms);
+
+  // 在样本上剖析，再重新编号
+  lexer.SetProfiling(true);
+  lexer.SetInput(sample);
+  lexer.Process();
+  lexer.SetProfiling(false);
+  size_t span_before = hot_span(lexer.GetStateVisits(0));
+  lexer.RenumberStates();
+  size_t span_after = hot_span(lexer.GetStateVisits(0));
+  cout << boolalpha << "states: " << transition.size() << ", 99% of row reads within the first "
+       << span_before << " rows -> " << span_after << " rows" << endl;
+
+  auto result = scan(lexer, text, after_ms);
+  cout << "renumbered equal: " << (result == expect) << endl;
+
+  // 保存并读入
+  stringstream file;
+  lexer.SaveTables(file);
+  SeuLex loaded(tokens, end_token);
+  loaded.LoadTables(file);
+  stringstream again;
+  loaded.SaveTables(again);
+  cout << "save/load: " << (scan(loaded, text, loaded_ms) == expect && again.str() == file.str()) << endl;
+
+  for (int round = 0; round < 3; ++round) {
+    scan(lexer, text, after_ms);
+    scan(loaded, text, loaded_ms);
+  }
+  SeuLex original(transition, accept, tokens, end_token);
+  for (int round = 0; round < 3; ++round) {
+    scan(original, text, before_ms);
+  }
+  cout << "discovery order: " << before_ms << " ms" << endl;
+  cout << "renumbered:      " << min(after_ms, loaded_ms) << " ms" << endl;
+
+  // 版本不对、关键字的规则越界、关键字重复：都应抛出异常并保留原有的表
+  auto with_keywords = [](const string &keywords) {
+    string table = "sly-lex-tables 1\n1\n1\n";
+    for (size_t c = 0; c < 128; ++c)
+      table += c + 1 < 128 ? "-1 " : "-1\n";
+    return table + "-1\n" + keywords;
+  };
+  bool thrown = true;
+  for (const auto &content :
+       {string("sly-lex-tables 2\n"), with_keywords("1\n-2 2 if\n"),
+        with_keywords("1\n100000 2 if\n"), with_keywords("2\n0 2 if\n1 2 if\n")}) {
+    try {
+      stringstream bad(content);
+      loaded.LoadTables(bad);
+      thrown = false;
+    } catch (const runtime_error &) {
+    }
+  }
+  cout << "invalid file: " << (thrown && scan(loaded, text, loaded_ms) == expect) << endl;
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file test21.cpp
+ * @brief 测试交错扫描多个输入与逐个扫描结果相同，并比较大量小文件的吞吐量
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::Lexeme;
+using sly::runtime::SeuLex;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((int))", R"((return))", R"((for))", R"((if))",
+    R"(//[^\n]*)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"([0-9]+)",
+    R"(L?"(\\.|[^\\"\n\r])*")",
+    R"((\+\+))", R"((<=))", R"((==))",
+    R"(;)", R"(\{)", R"(\})", R"(,)", R"(=)", R"(\()", R"(\))",
+    R"(\[)", R"(\])", R"(\+)", R"(\*)", R"(<)",
+    R"(( |\t|\n|\r)+)",
+};
+
+bool same(const vector<Lexeme> &a, const vector<Lexeme> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].rule != b[i].rule || a[i].offset != b[i].offset || a[i].length != b[i].length)
+      return false;
+  }
+  return true;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+  SeuLex lexer(transition, accept, tokens, end_token);
+
+  // 大量长度不一的小文件，其中包括空文件
+  mt19937 rng(20220330);
+  vector<string> files(4000);
+  for (auto &file : files) {
+    stringstream ss;
+    int functions = rng() % 12;
+    for (int i = 0; i < functions; ++i) {
+      ss << "int f" << i << "(int *a, int n) {\n  // sum " << rng() % 1000 << "\n"
+         << "  for (int i = 0; i <= n; i++) s = s + a[i] * " << rng() % 100 << ";\n"
+         << "  if (s == 0) puts(\"zero\");\n  return s;\n}\n";
+    }
+    file = ss.str();
+  }
+  vector<string_view> inputs(files.begin(), files.end());
+
+  vector<vector<Lexeme>> expect(files.size());
+  double sequential_ms = 1e9, interleaved_ms = 1e9;
+  size_t bytes = 0, count = 0;
+  for (const auto &file : files) {
+    bytes += file.size();
+  }
+  for (int round = 0; round < 5; ++round) {
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < files.size(); ++i) {
+      lexer.SetInput(files[i]);
+      lexer.Process();
+      expect[i] = lexer.GetLexemes();
+    }
+    auto t1 = chrono::steady_clock::now();
+    sequential_ms = min(sequential_ms, chrono::duration<double, milli>(t1 - t0).count());
+  }
+  vector<vector<Lexeme>> result;
+  for (int round = 0; round < 5; ++round) {
+    auto t0 = chrono::steady_clock::now();
+    result = lexer.LexStreams(inputs);
+    auto t1 = chrono::steady_clock::now();
+    interleaved_ms = min(interleaved_ms, chrono::duration<double, milli>(t1 - t0).count());
+  }
+  bool equal = result.size() == expect.size();
+  for (size_t i = 0; equal && i < files.size(); ++i) {
+    equal = same(result[i], expect[i]);
+    count += result[i].size();
+  }
+  cout << boolalpha << "streams equal: " << equal << " (" << files.size() << " files, "
+       << bytes / 1024 << " KB, " << count << " tokens)" << endl;
+  cout << "one at a time: " << sequential_ms << " ms" << endl;
+  cout << "interleaved:   " << interleaved_ms << " ms" << endl;
+
+  bool thrown = false;
+  try {
+    lexer.LexStreams({"int a;", "int @;"});
+  } catch (const runtime_error &) {
+    thrown = true;
+  }
+  cout << "lexical error: " << thrown << endl;
+
+  // 规则可以匹配空串时，停在入口状态的通道报告词法错误，而不是不断记录空的词法单元
+  vector<DfaModel> nullable_dfa = {RegEx("a*").GetDfaModel(), RegEx("b").GetDfaModel()};
+  auto [nullable_transition, nullable_accept] = DfaModel::Merge(nullable_dfa);
+  SeuLex nullable(nullable_transition, nullable_accept,
+                  {Token::Terminator("a*"), Token::Terminator("b")}, end_token);
+  auto lexed = nullable.LexStreams({"aab", "ba"});
+  nullable.SetInput("aab");
+  nullable.Process();
+  bool nullable_equal = same(lexed[0], nullable.GetLexemes());
+  thrown = false;
+  try {
+    nullable.LexStreams({"aab", "aa?"});
+  } catch (const runtime_error &) {
+    thrown = true;
+  }
+  cout << "empty match is a lexical error: " << (nullable_equal && lexed[1].size() == 2 && thrown)
+       << endl;
+  return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test22.cpp
+ * @brief 测试稠密分析表：逐格与 ParsingTable 比较，并比较两种表上分析同一输入的耗时
+ */
+
+#include "sly/DenseParsingTable.h"
+#include "sly/LrParser.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using sly::core::grammar::DenseParsingTable;
+using sly::core::grammar::LrParser;
+using sly::core::grammar::ParsingTable;
+using sly::core::type::AttrDict;
+using sly::core::type::Production;
+using sly::core::type::Token;
+using namespace std;
+
+/**
+ * 只维护状态栈，按 ParsingTable 的散列表查询，返回执行的动作数
+ */
+size_t run_map(const ParsingTable &table, const vector<Token> &tokens) {
+  vector<IdType> states{0};
+  size_t steps = 0, offset = 0;
+  while (offset < tokens.size()) {
+    auto act = table.GetAction(states.back(), tokens[offset]);
+    const auto &action = act.at(0);
+    ++steps;
+    if (action.action == ParsingTable::kShiftIn) {
+      states.push_back(action.id);
+      ++offset;
+    } else if (action.action == ParsingTable::kReduce) {
+      const auto &prod = table.GetProductions()[action.id];
+      states.resize(states.size() + 1 - prod.GetTokens().size());
+      states.push_back(
+          table.GetGoto(states.back(), prod.GetTokens().front()).at(0));
+    } else {
+      break;
+    }
+  }
+  return steps;
+}
+
+size_t run_dense(const DenseParsingTable &table, const vector<Token> &tokens) {
+  vector<int> symbols;
+  for (const auto &tok : tokens)
+    symbols.push_back(table.SymbolOf(tok));
+  vector<IdType> states{0};
+  size_t steps = 0, offset = 0;
+  while (offset < symbols.size()) {
+    auto action = table.GetAction(states.back(), symbols[offset]);
+    ++steps;
+    if (action.action == ParsingTable::kShiftIn) {
+      states.push_back(action.id);
+      ++offset;
+    } else if (action.action == ParsingTable::kReduce) {
+      states.resize(states.size() - table.GetRhsLength(action.id));
+      states.push_back(table.GetGoto(states.back(), table.GetLhs(action.id)));
+    } else {
+      break;
+    }
+  }
+  return steps;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  auto add = Token::Terminator("+", Token::Attr::kLeftAssociative);
+  auto multi = Token::Terminator("*", Token::Attr::kLeftAssociative);
+  auto alpha = Token::Terminator("a");
+  auto lb = Token::Terminator("(");
+  auto rb = Token::Terminator(")");
+  auto ending = Token::Terminator("EOF_FLAG");
+  auto expr = Token::NonTerminator("Expr");
+  auto term = Token::NonTerminator("Term");
+  auto fact = Token::NonTerminator("Fact");
+  vector<Production> productions = {
+      Production(expr, {[](vector<YYSTATE> &v) {
+                   v[0].Set<int>("value", (v[1].Get<int>("value") +
+                                           v[3].Get<int>("value")) % 10007);
+                 }})(expr)(add)(term),
+      Production(expr, {[](vector<YYSTATE> &v) {
+                   v[0].Set<int>("value", v[1].Get<int>("value"));
+                 }})(term),
+      Production(term, {[](vector<YYSTATE> &v) {
+                   v[0].Set<int>("value", (v[1].Get<int>("value") *
+                                           v[3].Get<int>("value")) % 10007);
+                 }})(term)(multi)(fact),
+      Production(term, {[](vector<YYSTATE> &v) {
+                   v[0].Set<int>("value", v[1].Get<int>("value"));
+                 }})(fact),
+      Production(fact, {[](vector<YYSTATE> &v) {
+                   v[0].Set<int>("value", v[2].Get<int>("value"));
+                 }})(lb)(expr)(rb),
+      Production(fact, {[](vector<YYSTATE> &v) {
+                   v[0].Set<int>("value", v[1].Get<int>("value"));
+                 }})(alpha),
+  };
+  sly::core::grammar::ContextFreeGrammar cfg(productions, expr, ending);
+  sly::core::grammar::Lr1 lr1;
+  cfg.Compile(lr1);
+  auto table = cfg.GetLrTable();
+  DenseParsingTable dense(table);
+
+  // 1. 逐格比较
+  bool same = true;
+  for (IdType i = 0; i < dense.GetStateCount(); ++i) {
+    for (size_t s = 0; s < dense.GetSymbolCount(); ++s) {
+      const auto &tok = dense.GetSymbols()[s];
+      if (s < dense.GetTerminatorCount()) {
+        auto expected = table.GetAction(i, tok);
+        auto cell = dense.GetAction(i, static_cast<int>(s));
+        if (expected.empty() || expected[0].action == ParsingTable::kError)
+          same = same && cell.action == ParsingTable::kError;
+        else
+          same = same && expected.size() == 1 &&
+                 cell.action == expected[0].action &&
+                 (cell.action == ParsingTable::kAccept ||
+                  cell.id == expected[0].id);
+      } else {
+        auto expected = table.GetGoto(i, tok);
+        int go = dense.GetGoto(i, static_cast<int>(s));
+        same = same && (expected.empty() ? go == -1
+                                         : go == static_cast<int>(expected[0]));
+      }
+    }
+  }
+  cout << "states: " << dense.GetStateCount()
+       << ", symbols: " << dense.GetSymbolCount() << " ("
+       << dense.GetTerminatorCount() << " terminators)" << endl;
+  cout << "cells equal: " << boolalpha << same << endl;
+
+  // 2. 随机表达式，计算期望值
+  mt19937 rng(42);
+  vector<Token> tokens;
+  vector<AttrDict> attributes;
+  auto emit = [&](const Token &tok, int value = 0) {
+    AttrDict ad;
+    ad.Set<int>("value", value);
+    tokens.push_back(tok);
+    attributes.push_back(ad);
+  };
+  int expected_value = 0;
+  for (int i = 0; i < 3000; ++i) {
+    int a = static_cast<int>(rng() % 100), b = static_cast<int>(rng() % 100),
+        c = static_cast<int>(rng() % 100);
+    if (i != 0)
+      emit(add);
+    // a * ( b + c )
+    emit(alpha, a);
+    emit(multi);
+    emit(lb);
+    emit(alpha, b);
+    emit(add);
+    emit(alpha, c);
+    emit(rb);
+    expected_value = (expected_value + a * ((b + c) % 10007) % 10007) % 10007;
+  }
+  emit(ending);
+
+  LrParser parser(table);
+  parser.Parse(tokens, attributes);
+  auto tree = parser.GetTree();
+  tree.Annotate();
+  int value = tree.GetRootAttributes()[0].Get<int>("value");
+  cout << "parse value: " << value << " expected: " << expected_value << endl;
+  cout << "parse equal: " << boolalpha << (value == expected_value) << endl;
+
+  // 3. 只比较查表：同一输入分别在散列表与稠密表上运行
+  const int rounds = 20;
+  size_t map_steps = 0, dense_steps = 0;
+  auto t0 = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    map_steps += run_map(table, tokens);
+  auto t1 = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    dense_steps += run_dense(dense, tokens);
+  auto t2 = chrono::steady_clock::now();
+  cout << "steps equal: " << boolalpha << (map_steps == dense_steps) << " ("
+       << map_steps / rounds << " steps)" << endl;
+  cout << "map table:   "
+       << chrono::duration<double, milli>(t1 - t0).count() / rounds << " ms"
+       << endl;
+  cout << "dense table: "
+       << chrono::duration<double, milli>(t2 - t1).count() / rounds << " ms"
+       << endl;
+
+  // 4. 文法中没有的终结符与其他语法错误一样报告后以 exit(1) 结束，而不是抛出异常
+  pid_t pid = fork();
+  if (pid == 0) {
+    spdlog::set_level(spdlog::level::off);
+    vector<Token> bad = {alpha, Token::Terminator("-"), alpha, ending};
+    vector<AttrDict> bad_attributes(bad.size());
+    for (size_t i = 0; i < bad.size(); ++i) {
+      bad_attributes[i].Set<int>("row", 1);
+      bad_attributes[i].Set<int>("col", static_cast<int>(i));
+    }
+    LrParser(table).Parse(bad, bad_attributes);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  cout << "unknown terminal is a syntax error: " << boolalpha
+       << (WIFEXITED(status) && WEXITSTATUS(status) == 1) << endl;
+  return 0;
+}
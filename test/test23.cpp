@@ -0,0 +1,154 @@
+/**
+ * @file test23.cpp
+ * @brief 测试压缩分析表：与稠密表逐格比较、统计压缩后的大小，并在随机生成的句子上比较分析结果与耗时
+ *
+ * 用法：test23 [yacc 文件]，默认为 ../demo/c9.y
+ */
+
+#include "sly/CompressedParsingTable.h"
+#include "sly/DenseParsingTable.h"
+#include "sly/LrParser.h"
+#include "grammar_fixture.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::grammar::CompressedParsingTable;
+using sly::core::grammar::DenseParsingTable;
+using sly::core::grammar::LrParser;
+using sly::core::grammar::ParsingTable;
+using sly::core::grammar::ParsingTableKind;
+using sly::core::type::AttrDict;
+using sly::core::type::Token;
+using namespace std;
+
+template <typename Table>
+size_t run(const Table &table, const vector<int> &symbols) {
+  vector<IdType> states{0};
+  size_t steps = 0, offset = 0;
+  while (offset < symbols.size()) {
+    auto action = table.GetAction(states.back(), symbols[offset]);
+    ++steps;
+    if (action.action == ParsingTable::kShiftIn) {
+      states.push_back(action.id);
+      ++offset;
+    } else if (action.action == ParsingTable::kReduce) {
+      states.resize(states.size() - table.GetRhsLength(action.id));
+      states.push_back(table.GetGoto(states.back(), table.GetLhs(action.id)));
+    } else {
+      break;
+    }
+  }
+  return steps;
+}
+
+int main(int argc, char **argv) {
+  spdlog::set_level(spdlog::level::err);
+  string path = argc > 1 ? argv[1] : "../demo/c9.y";
+  Token start, ending = Token::Terminator("EOF_FLAG");
+  auto productions = load_grammar(path, start);
+  sly::core::grammar::ContextFreeGrammar cfg(productions, start, ending);
+  sly::core::grammar::Lr1 lr1;
+  auto t0 = chrono::steady_clock::now();
+  cfg.Compile(lr1);
+  auto t1 = chrono::steady_clock::now();
+  auto table = cfg.GetLrTable();
+  DenseParsingTable dense(table);
+  CompressedParsingTable compressed(dense);
+  auto t2 = chrono::steady_clock::now();
+  cout << path << ": " << productions.size() << " productions, "
+       << dense.GetStateCount() << " states, " << dense.GetSymbolCount()
+       << " symbols" << endl;
+  cout << "lr1 " << chrono::duration<double, milli>(t1 - t0).count()
+       << " ms, dense + compressed "
+       << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+
+  // 1. 非错误格子必须一致，错误格子只能变为默认规约
+  bool same = true;
+  for (IdType i = 0; i < dense.GetStateCount(); ++i) {
+    for (int s = 0; s < static_cast<int>(dense.GetSymbolCount()); ++s) {
+      if (s < static_cast<int>(dense.GetTerminatorCount())) {
+        auto expected = dense.GetAction(i, s);
+        auto cell = compressed.GetAction(i, s);
+        if (expected.action == ParsingTable::kError)
+          same = same && (cell.action == ParsingTable::kError ||
+                          cell.action == ParsingTable::kReduce);
+        else
+          same = same && cell.action == expected.action &&
+                 cell.id == expected.id;
+      } else if (dense.GetGoto(i, s) >= 0) {
+        same = same && compressed.GetGoto(i, s) == dense.GetGoto(i, s);
+      }
+    }
+  }
+  cout << "cells equal: " << boolalpha << same << endl;
+
+  size_t n_states = dense.GetStateCount();
+  size_t n_non_terminators = dense.GetSymbolCount() - dense.GetTerminatorCount();
+  size_t dense_size = n_states * dense.GetSymbolCount();
+  // table + check，外加每个状态的位移与默认动作、每个非终结符的位移与默认 GOTO
+  size_t compressed_size = 2 * compressed.GetPackedSize() + 2 * n_states +
+                           2 * n_non_terminators;
+  cout << "dense cells: " << dense_size
+       << ", compressed cells: " << compressed_size << " (packed "
+       << compressed.GetPackedSize() << ", shared vectors "
+       << compressed.GetSharedVectorCount() << ", forced reductions "
+       << compressed.GetForcedReductionCount() << ")" << endl;
+
+  // 2. 随机句子（取若干次推导中最长的一个）：两种表得到相同的分析树
+  SentenceGenerator generator(cfg.GetProductions(), 42);
+  vector<Token> sentence;
+  for (int attempt = 0; attempt < 50; ++attempt) {
+    vector<Token> candidate;
+    generator.Derive(start, 0, 20, candidate);
+    if (candidate.size() > sentence.size() && candidate.size() <= 5000)
+      sentence = candidate;
+  }
+  sentence.push_back(ending);
+  vector<AttrDict> attributes(sentence.size());
+  for (size_t i = 0; i < sentence.size(); ++i) {
+    attributes[i].Set<int>("row", 1);
+    attributes[i].Set<int>("col", static_cast<int>(i));
+    attributes[i].Set<string>("lval", sentence[i].GetTokName());
+  }
+
+  auto print_tree = [&](ParsingTableKind kind) {
+    LrParser parser(table);
+    parser.SetTableKind(kind);
+    parser.Parse(sentence, attributes);
+    stringstream ss;
+    parser.GetTree().PrintForShort(ss, false);
+    return ss.str();
+  };
+  cout << "sentence tokens: " << sentence.size() << endl;
+  cout << "tree equal: " << boolalpha
+       << (print_tree(ParsingTableKind::kDense) ==
+           print_tree(ParsingTableKind::kCompressed))
+       << endl;
+
+  // 3. 只比较查表：重复分析同一个句子
+  vector<int> symbols;
+  for (const auto &tok : sentence)
+    symbols.push_back(dense.SymbolOf(tok));
+  const int rounds = 2000;
+  size_t dense_steps = 0, compressed_steps = 0;
+  auto t3 = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    dense_steps += run(dense, symbols);
+  auto t4 = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    compressed_steps += run(compressed, symbols);
+  auto t5 = chrono::steady_clock::now();
+  cout << "steps equal: " << boolalpha << (dense_steps == compressed_steps)
+       << " (" << dense_steps / rounds << " steps)" << endl;
+  cout << "dense table:      "
+       << chrono::duration<double, micro>(t4 - t3).count() / rounds << " us"
+       << endl;
+  cout << "compressed table: "
+       << chrono::duration<double, micro>(t5 - t4).count() / rounds << " us"
+       << endl;
+  return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test24.cpp
+ * @brief 测试 LALR(1)：与 LR(1) 比较状态数、生成耗时与冲突，并在随机句子上比较分析树
+ *
+ * 用法：test24 [yacc 文件]，默认为 ../demo/c9.y
+ */
+
+#include "sly/LrParser.h"
+#include "grammar_fixture.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::grammar::Lalr;
+using sly::core::grammar::Lr1;
+using sly::core::grammar::LrParser;
+using sly::core::grammar::ParsingTable;
+using sly::core::type::AttrDict;
+using sly::core::type::Token;
+using namespace std;
+
+int main(int argc, char **argv) {
+  spdlog::set_level(spdlog::level::err);
+  string path = argc > 1 ? argv[1] : "../demo/c9.y";
+  Token start, ending = Token::Terminator("EOF_FLAG");
+  auto productions = load_grammar(path, start);
+
+  sly::core::grammar::ContextFreeGrammar cfg_lalr(productions, start, ending);
+  Lalr lalr;
+  auto t0 = chrono::steady_clock::now();
+  cfg_lalr.Compile(lalr);
+  auto t1 = chrono::steady_clock::now();
+
+  sly::core::grammar::ContextFreeGrammar cfg_lr1(productions, start, ending);
+  Lr1 lr1;
+  cfg_lr1.Compile(lr1);
+  auto t2 = chrono::steady_clock::now();
+
+  cout << path << ": " << productions.size() << " productions" << endl;
+  cout << "lalr: " << lalr.GetStateCount() << " states, "
+       << chrono::duration<double, milli>(t1 - t0).count() << " ms, "
+       << lalr.GetConflicts().size() << " conflicts" << endl;
+  cout << "lr1:  " << lr1.GetStateCount() << " states, "
+       << chrono::duration<double, milli>(t2 - t1).count() << " ms, "
+       << lr1.GetConflicts().size() << " conflicts" << endl;
+
+  auto lalr_conflicts = conflict_set(lalr), lr1_conflicts = conflict_set(lr1);
+  size_t extra = 0;
+  for (const auto &c : lalr_conflicts) {
+    if (lr1_conflicts.find(c) == lr1_conflicts.end()) {
+      ++extra;
+      cout << "extra " << (get<0>(c) ? "shift-in/reduce" : "reduce/reduce")
+           << " conflict on " << get<1>(c) << endl;
+    }
+  }
+  cout << "extra conflicts from merging: " << extra << endl;
+
+  // 随机句子：两张表得到相同的分析树
+  auto lalr_table = cfg_lalr.GetLrTable(), lr1_table = cfg_lr1.GetLrTable();
+  SentenceGenerator generator(cfg_lr1.GetProductions(), 7);
+  bool same = true;
+  size_t total_tokens = 0;
+  for (int n = 0; n < 20; ++n) {
+    vector<Token> sentence;
+    for (int attempt = 0; attempt < 10; ++attempt) {
+      vector<Token> candidate;
+      generator.Derive(start, 0, 16, candidate);
+      if (candidate.size() > sentence.size() && candidate.size() <= 3000)
+        sentence = candidate;
+    }
+    sentence.push_back(ending);
+    total_tokens += sentence.size();
+    vector<AttrDict> attributes(sentence.size());
+    for (size_t i = 0; i < sentence.size(); ++i) {
+      attributes[i].Set<int>("row", 1);
+      attributes[i].Set<int>("col", static_cast<int>(i));
+      attributes[i].Set<string>("lval", sentence[i].GetTokName());
+    }
+    auto print_tree = [&](ParsingTable &table) {
+      LrParser parser(table);
+      parser.Parse(sentence, attributes);
+      stringstream ss;
+      parser.GetTree().PrintForShort(ss, false);
+      return ss.str();
+    };
+    same = same && print_tree(lalr_table) == print_tree(lr1_table);
+  }
+  cout << "sentences: 20 (" << total_tokens << " tokens)" << endl;
+  cout << "tree equal: " << boolalpha << same << endl;
+  return 0;
+}
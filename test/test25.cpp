@@ -0,0 +1,148 @@
+/**
+ * @file test25.cpp
+ * @brief 测试最小 LR(1)：在非 LALR(1) 文法上没有冲突；
+ * 给出 yacc 文件时与 LR(1)、LALR(1) 比较状态数、生成耗时与冲突，并在随机句子上比较分析树
+ *
+ * 用法：test25 [yacc 文件]
+ */
+
+#include "sly/LrParser.h"
+#include "grammar_fixture.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::grammar::ContextFreeGrammar;
+using sly::core::grammar::Lalr;
+using sly::core::grammar::Lr1;
+using sly::core::grammar::LrParser;
+using sly::core::grammar::LrTableGenerateMethod;
+using sly::core::grammar::MinimalLr1;
+using sly::core::grammar::ParsingTable;
+using sly::core::type::AttrDict;
+using sly::core::type::Production;
+using sly::core::type::Token;
+using namespace std;
+
+vector<AttrDict> attributes_of(const vector<Token> &sentence) {
+  vector<AttrDict> attributes(sentence.size());
+  for (size_t i = 0; i < sentence.size(); ++i) {
+    attributes[i].Set<int>("row", 1);
+    attributes[i].Set<int>("col", static_cast<int>(i));
+    attributes[i].Set<string>("lval", sentence[i].GetTokName());
+  }
+  return attributes;
+}
+
+string print_tree(ParsingTable &table, const vector<Token> &sentence) {
+  LrParser parser(table);
+  parser.Parse(sentence, attributes_of(sentence));
+  stringstream ss;
+  parser.GetTree().PrintForShort(ss, false);
+  return ss.str();
+}
+
+/**
+ * S -> a A d | b B d | a B e | b A e, A -> c, B -> c
+ * 是 LR(1) 而不是 LALR(1) 的文法：合并 A -> c. 与 B -> c. 所在的同心项集会产生
+ * reduce <> reduce 冲突，弱相容条件不允许这样的合并。
+ */
+void test_non_lalr() {
+  Token S = Token::NonTerminator("S"), A = Token::NonTerminator("A"),
+        B = Token::NonTerminator("B");
+  Token a = Token::Terminator("a"), b = Token::Terminator("b"),
+        c = Token::Terminator("c"), d = Token::Terminator("d"),
+        e = Token::Terminator("e"), ending = Token::Terminator("EOF_FLAG");
+  vector<Production> productions{
+      Production(S)(a)(A)(d), Production(S)(b)(B)(d), Production(S)(a)(B)(e),
+      Production(S)(b)(A)(e), Production(A)(c),       Production(B)(c)};
+
+  ContextFreeGrammar cfg_lalr(productions, S, ending);
+  Lalr lalr;
+  cfg_lalr.Compile(lalr);
+  ContextFreeGrammar cfg_lr1(productions, S, ending);
+  Lr1 lr1;
+  cfg_lr1.Compile(lr1);
+  ContextFreeGrammar cfg(productions, S, ending);
+  MinimalLr1 minimal;
+  cfg.Compile(minimal);
+  cout << "non-LALR grammar: lalr " << lalr.GetStateCount() << " states / "
+       << lalr.GetConflicts().size() << " conflicts, lr1 "
+       << lr1.GetStateCount() << " states / " << lr1.GetConflicts().size()
+       << " conflicts, minimal " << minimal.GetStateCount() << " states / "
+       << minimal.GetConflicts().size() << " conflicts" << endl;
+  cout << "no conflicts: " << boolalpha << minimal.GetConflicts().empty()
+       << endl;
+
+  auto table = cfg.GetLrTable(), lr1_table = cfg_lr1.GetLrTable();
+  bool same = true;
+  for (const auto &sentence : vector<vector<Token>>{{a, c, d, ending},
+                                                    {b, c, d, ending},
+                                                    {a, c, e, ending},
+                                                    {b, c, e, ending}}) {
+    same = same && print_tree(table, sentence) == print_tree(lr1_table, sentence);
+  }
+  cout << "tree equal: " << boolalpha << same << endl;
+}
+
+void test_grammar(const string &path) {
+  Token start, ending = Token::Terminator("EOF_FLAG");
+  auto productions = load_grammar(path, start);
+  cout << path << ": " << productions.size() << " productions" << endl;
+
+  ContextFreeGrammar cfg_lalr(productions, start, ending);
+  Lalr lalr;
+  auto t0 = chrono::steady_clock::now();
+  cfg_lalr.Compile(lalr);
+  auto t1 = chrono::steady_clock::now();
+  ContextFreeGrammar cfg(productions, start, ending);
+  MinimalLr1 minimal;
+  cfg.Compile(minimal);
+  auto t2 = chrono::steady_clock::now();
+  ContextFreeGrammar cfg_lr1(productions, start, ending);
+  Lr1 lr1;
+  cfg_lr1.Compile(lr1);
+  auto t3 = chrono::steady_clock::now();
+
+  auto report = [](const char *name, const LrTableGenerateMethod &method,
+                   auto from, auto to) {
+    cout << name << method.GetStateCount() << " states, "
+         << chrono::duration<double, milli>(to - from).count() << " ms, "
+         << method.GetConflicts().size() << " conflicts" << endl;
+  };
+  report("lalr:    ", lalr, t0, t1);
+  report("minimal: ", minimal, t1, t2);
+  report("lr1:     ", lr1, t2, t3);
+  cout << "same conflicts as lr1: " << boolalpha
+       << (conflict_set(minimal) == conflict_set(lr1)) << endl;
+
+  auto table = cfg.GetLrTable(), lr1_table = cfg_lr1.GetLrTable();
+  SentenceGenerator generator(cfg_lr1.GetProductions(), 11);
+  bool same = true;
+  size_t total_tokens = 0;
+  for (int n = 0; n < 20; ++n) {
+    vector<Token> sentence;
+    for (int attempt = 0; attempt < 10; ++attempt) {
+      vector<Token> candidate;
+      generator.Derive(start, 0, 16, candidate);
+      if (candidate.size() > sentence.size() && candidate.size() <= 3000)
+        sentence = candidate;
+    }
+    sentence.push_back(ending);
+    total_tokens += sentence.size();
+    same = same && print_tree(table, sentence) == print_tree(lr1_table, sentence);
+  }
+  cout << "sentences: 20 (" << total_tokens << " tokens)" << endl;
+  cout << "tree equal: " << boolalpha << same << endl;
+}
+
+int main(int argc, char **argv) {
+  spdlog::set_level(spdlog::level::err);
+  test_non_lalr();
+  if (argc > 1)
+    test_grammar(argv[1]);
+  return 0;
+}
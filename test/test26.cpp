@@ -0,0 +1,79 @@
+/**
+ * @file test26.cpp
+ * @brief 测试多线程构造 LR(1) 项集族与分析表：不同线程数得到的分析表、状态数与冲突
+ * 与单线程完全相同，并报告各线程数的耗时
+ *
+ * 用法：test26 [yacc 文件]，默认为 ../demo/c9.y
+ */
+
+#include "grammar_fixture.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using sly::core::grammar::ContextFreeGrammar;
+using sly::core::grammar::Lalr;
+using sly::core::grammar::Lr1;
+using sly::core::grammar::LrTableGenerateMethod;
+using sly::core::grammar::MinimalLr1;
+using sly::core::grammar::ParsingTable;
+using sly::core::type::Production;
+using sly::core::type::Token;
+using namespace std;
+
+bool same_conflicts(const LrTableGenerateMethod &a,
+                    const LrTableGenerateMethod &b) {
+  const auto &x = a.GetConflicts(), &y = b.GetConflicts();
+  if (x.size() != y.size())
+    return false;
+  for (size_t i = 0; i < x.size(); ++i) {
+    if (x[i].state != y[i].state || !(x[i].token == y[i].token) ||
+        x[i].shift_reduce != y[i].shift_reduce ||
+        x[i].productions != y[i].productions)
+      return false;
+  }
+  return true;
+}
+
+template <typename Method>
+void test_method(const char *name, const vector<Production> &productions,
+                 const Token &start, const Token &ending,
+                 const vector<size_t> &thread_counts) {
+  ContextFreeGrammar base_cfg(productions, start, ending);
+  Method base;
+  base_cfg.Compile(base);
+  const auto &expected = base.GetParsingTable();
+  for (auto n : thread_counts) {
+    ContextFreeGrammar cfg(productions, start, ending);
+    Method method;
+    method.SetThreadCount(n);
+    auto t0 = chrono::steady_clock::now();
+    cfg.Compile(method);
+    auto t1 = chrono::steady_clock::now();
+    const auto &table = method.GetParsingTable();
+    bool same = method.GetStateCount() == base.GetStateCount() &&
+                table.GetActionTable() == expected.GetActionTable() &&
+                table.GetGotoTable() == expected.GetGotoTable() &&
+                same_conflicts(method, base);
+    cout << name << " threads " << n << ": " << method.GetStateCount()
+         << " states, " << chrono::duration<double, milli>(t1 - t0).count()
+         << " ms, identical: " << boolalpha << same << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  spdlog::set_level(spdlog::level::err);
+  string path = argc > 1 ? argv[1] : "../demo/c9.y";
+  Token start, ending = Token::Terminator("EOF_FLAG");
+  auto productions = load_grammar(path, start);
+  cout << path << ": " << productions.size() << " productions, "
+       << thread::hardware_concurrency() << " hardware threads" << endl;
+  vector<size_t> thread_counts{1, 2, 4, 8};
+  test_method<Lr1>("lr1    ", productions, start, ending, thread_counts);
+  test_method<MinimalLr1>("minimal", productions, start, ending, thread_counts);
+  test_method<Lalr>("lalr   ", productions, start, ending, thread_counts);
+  return 0;
+}
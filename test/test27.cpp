@@ -0,0 +1,157 @@
+/**
+ * @file test27.cpp
+ * @brief 测试 GrammarIndex 的 FIRST / FOLLOW / 后缀 FIRST：与按 Token 集合迭代到不动点的
+ * 朴素算法比较结果与耗时
+ *
+ * 用法：test27 [yacc 文件]，默认为 ../demo/c9.y
+ */
+
+#include "grammar_fixture.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+using sly::core::grammar::ContextFreeGrammar;
+using sly::core::grammar::GrammarIndex;
+using sly::core::grammar::TerminalSet;
+using sly::core::type::Token;
+using namespace std;
+
+using TokenSet = unordered_set<Token, Token::Hash>;
+
+/**
+ * 朴素算法：反复扫描全部产生式直到 FIRST / FOLLOW 不再变化，空串记为 epsilon
+ */
+struct NaiveSets {
+  unordered_map<Token, TokenSet, Token::Hash> first, follow;
+
+  const ContextFreeGrammar &cfg;
+
+  explicit NaiveSets(const ContextFreeGrammar &g) : cfg(g) {
+    for (const auto &tok : cfg.GetTerminators())
+      first[tok] = {tok};
+    for (const auto &tok : cfg.GetNonTerminators())
+      first[tok] = {}, follow[tok] = {};
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (const auto &prod : cfg.GetProductions()) {
+        const auto &tokens = prod.GetTokens();
+        for (const auto &tok : FirstOf(tokens.begin() + 1, tokens.end()))
+          changed = first[tokens.front()].insert(tok).second || changed;
+      }
+    }
+    follow[cfg.GetAugmentedToken()].insert(cfg.GetEndingToken());
+    changed = true;
+    while (changed) {
+      changed = false;
+      for (const auto &prod : cfg.GetProductions()) {
+        const auto &tokens = prod.GetTokens();
+        for (auto it = tokens.begin() + 1; it != tokens.end(); ++it) {
+          if (it->GetTokenType() != Token::Type::kNonTerminator)
+            continue;
+          auto rest = FirstOf(it + 1, tokens.end());
+          if (rest.erase(cfg.GetEpsilonToken())) {
+            auto lhs_follow = follow[tokens.front()];
+            rest.insert(lhs_follow.begin(), lhs_follow.end());
+          }
+          for (const auto &tok : rest)
+            changed = follow[*it].insert(tok).second || changed;
+        }
+      }
+    }
+  }
+
+  TokenSet FirstOf(vector<Token>::const_iterator first_tok,
+                   vector<Token>::const_iterator last) {
+    TokenSet result;
+    for (; first_tok != last; ++first_tok) {
+      if (first_tok->GetTokenType() == Token::Type::kEpsilon)
+        continue;
+      const auto &f = first[*first_tok];
+      bool nullable = f.count(cfg.GetEpsilonToken()) > 0;
+      for (const auto &tok : f) {
+        if (!(tok == cfg.GetEpsilonToken()))
+          result.insert(tok);
+      }
+      if (!nullable)
+        return result;
+    }
+    result.insert(cfg.GetEpsilonToken());
+    return result;
+  }
+};
+
+/**
+ * 把位串转换为 Token 集合，nullable 时加入 epsilon
+ */
+TokenSet to_tokens(const GrammarIndex &index, const TerminalSet &set,
+                   bool nullable, const Token &epsilon) {
+  TokenSet result;
+  set.ForEach([&](size_t t) { result.insert(index.TokenOf(t)); });
+  if (nullable)
+    result.insert(epsilon);
+  return result;
+}
+
+int main(int argc, char **argv) {
+  spdlog::set_level(spdlog::level::err);
+  string path = argc > 1 ? argv[1] : "../demo/c9.y";
+  Token start, ending = Token::Terminator("EOF_FLAG");
+  auto productions = load_grammar(path, start);
+  ContextFreeGrammar cfg(productions, start, ending);
+  // 编译一次，使文法加入增广产生式并完成检查
+  sly::core::grammar::Lalr lalr;
+  cfg.Compile(lalr);
+  const auto &epsilon = cfg.GetEpsilonToken();
+
+  const int rounds = 20;
+  auto t0 = chrono::steady_clock::now();
+  for (int r = 0; r + 1 < rounds; ++r)
+    GrammarIndex warm(cfg);
+  GrammarIndex index(cfg);
+  auto t1 = chrono::steady_clock::now();
+  for (int r = 0; r + 1 < rounds; ++r)
+    NaiveSets warm(cfg);
+  NaiveSets naive(cfg);
+  auto t2 = chrono::steady_clock::now();
+  cout << path << ": " << index.GetProductionCount() << " productions, "
+       << index.GetSymbolCount() << " symbols" << endl;
+
+  bool first_equal = true, follow_equal = true, suffix_equal = true;
+  for (int s = 0; s < static_cast<int>(index.GetSymbolCount()); ++s) {
+    const auto &tok = index.TokenOf(s);
+    first_equal = first_equal &&
+                  to_tokens(index, index.GetFirst(s), index.IsNullable(s),
+                            epsilon) == naive.first.at(tok);
+    if (!index.IsTerminator(s))
+      follow_equal = follow_equal &&
+                     to_tokens(index, index.GetFollow(s), false, epsilon) ==
+                         naive.follow.at(tok);
+  }
+  for (IdType p = 0; p < index.GetProductionCount(); ++p) {
+    const auto &tokens = cfg.GetProductions()[p].GetTokens();
+    for (size_t pos = 0; pos <= index.GetRhs(p).size(); ++pos) {
+      // epsilon 产生式的右部在 GrammarIndex 中为空
+      auto from = index.GetRhs(p).empty() ? tokens.end()
+                                          : tokens.begin() + 1 + pos;
+      suffix_equal = suffix_equal &&
+                     to_tokens(index, index.GetFirst(p, pos),
+                               index.IsNullable(p, pos), epsilon) ==
+                         naive.FirstOf(from, tokens.end());
+    }
+  }
+  cout << "first equal: " << boolalpha << first_equal << endl;
+  cout << "follow equal: " << boolalpha << follow_equal << endl;
+  cout << "suffix first equal: " << boolalpha << suffix_equal << endl;
+  cout << "grammar index: "
+       << chrono::duration<double, milli>(t1 - t0).count() / rounds << " ms"
+       << endl;
+  cout << "naive fixpoint: "
+       << chrono::duration<double, milli>(t2 - t1).count() / rounds << " ms"
+       << endl;
+  return 0;
+}
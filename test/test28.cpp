@@ -0,0 +1,114 @@
+/**
+ * @file test28.cpp
+ * @brief 测试产生式很多的文法：编译耗时、按 token 序列查找产生式与逐个比较的结果一致，
+ * 以及重复产生式仍然会被检查出来
+ *
+ * 用法：test28 [链长 n]，默认为 2000，文法共 2n + 2 个产生式
+ */
+
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using sly::core::grammar::ContextFreeGrammar;
+using sly::core::grammar::Lalr;
+using sly::core::grammar::Lr1;
+using sly::core::type::Production;
+using sly::core::type::Token;
+using namespace std;
+
+/**
+ * L_k -> t_{k%64} L_{k+1} | u_{k%64}，L_n -> end
+ */
+vector<Production> chain_grammar(size_t n) {
+  vector<Production> productions;
+  auto nt = [](size_t k) { return Token::NonTerminator("L" + to_string(k)); };
+  for (size_t k = 0; k < n; ++k) {
+    productions.push_back(Production(nt(k))(
+        Token::Terminator("t" + to_string(k % 64)))(nt(k + 1)));
+    productions.push_back(
+        Production(nt(k))(Token::Terminator("u" + to_string(k % 64))));
+  }
+  productions.push_back(Production(nt(n))(Token::Terminator("end")));
+  return productions;
+}
+
+int main(int argc, char **argv) {
+  spdlog::set_level(spdlog::level::err);
+  size_t n = argc > 1 ? stoul(argv[1]) : 2000;
+  auto productions = chain_grammar(n);
+  Token start = Token::NonTerminator("L0"),
+        ending = Token::Terminator("EOF_FLAG");
+
+  ContextFreeGrammar cfg(productions, start, ending);
+  Lalr lalr;
+  auto t0 = chrono::steady_clock::now();
+  cfg.Compile(lalr);
+  auto t1 = chrono::steady_clock::now();
+  ContextFreeGrammar cfg_lr1(productions, start, ending);
+  Lr1 lr1;
+  cfg_lr1.Compile(lr1);
+  auto t2 = chrono::steady_clock::now();
+  cout << cfg.GetProductions().size() << " productions" << endl;
+  cout << "lalr " << lalr.GetStateCount() << " states, "
+       << chrono::duration<double, milli>(t1 - t0).count() << " ms, "
+       << lalr.GetConflicts().size() << " conflicts" << endl;
+  cout << "lr1  " << lr1.GetStateCount() << " states, "
+       << chrono::duration<double, milli>(t2 - t1).count() << " ms, "
+       << lr1.GetConflicts().size() << " conflicts" << endl;
+
+  // 1. 按 token 序列查找与逐个比较一致
+  const auto &prods = cfg.GetProductions();
+  bool find_equal = true;
+  for (IdType p = 0; p < prods.size(); ++p) {
+    IdType expected = 0;
+    while (!(prods[expected].GetTokens() == prods[p].GetTokens()))
+      ++expected;
+    find_equal = find_equal && cfg.FindProd(prods[p].GetTokens()) == expected;
+  }
+  find_equal = find_equal && !cfg.FindProd({start, ending}).has_value();
+  cout << "find prod equal: " << boolalpha << find_equal << endl;
+
+  // 2. 原有的两两比较，作为对照
+  auto t3 = chrono::steady_clock::now();
+  size_t duplicated = 0;
+  for (const auto &pi : prods) {
+    int count = 0;
+    for (const auto &pj : prods) {
+      if (pi == pj)
+        count += 1;
+    }
+    if (count > 1)
+      ++duplicated;
+  }
+  auto t4 = chrono::steady_clock::now();
+  cout << "pairwise duplicate check: "
+       << chrono::duration<double, milli>(t4 - t3).count() << " ms ("
+       << duplicated << " duplicated)" << endl;
+
+  // 3. 重复产生式仍然报错
+  auto with_duplicate = productions;
+  with_duplicate.push_back(productions[n]);
+  ContextFreeGrammar cfg_dup(with_duplicate, start, ending);
+  bool dup_thrown = false;
+  try {
+    Lalr method;
+    cfg_dup.Compile(method);
+  } catch (const runtime_error &) {
+    dup_thrown = true;
+  }
+  cout << "duplicate rejected: " << boolalpha << dup_thrown << endl;
+
+  // 4. 产生式中出现结束符时，终结符表里只有一个结束符
+  ContextFreeGrammar cfg_end({Production(start)(ending)}, start, ending);
+  Lalr method;
+  cfg_end.Compile(method);
+  const auto &terminators = cfg_end.GetTerminators();
+  cout << "ending token once: " << boolalpha
+       << (count(terminators.begin(), terminators.end(), ending) == 1) << endl;
+  return 0;
+}
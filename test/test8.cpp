@@ -0,0 +1,123 @@
+/**
+ * @file test8.cpp
+ * @brief 测试 MergedDfaModel 的增量更新与独立实现的乘积构造结果一致
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::MergedDfaModel;
+using sly::core::lexical::RegEx;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((int))",
+    R"((return))",
+    R"([0-9]+)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"(L?"(\\.|[^\\"\n\r])*")",
+    R"(;)",
+    R"(\()",
+    R"(\))",
+    R"(=)",
+    R"(\+)",
+    R"(( |\t|\n|\r))",
+};
+
+/**
+ * 作为对照的乘积构造（原来 DfaModel::Merge 的做法），不经过 MergedDfaModel：
+ * 从各 dfa 入口组成的状态出发，按字符从小到大广度优先展开
+ */
+pair<vector<vector<int>>, vector<int>> reference_merge(const vector<DfaModel> &dfa_list) {
+  vector<vector<int>> states{vector<int>(dfa_list.size(), DfaModel::entry_)};
+  map<vector<int>, int> state_id{{states.front(), 0}};
+  vector<vector<int>> transition;
+  vector<int> accept;
+  for (size_t i = 0; i < states.size(); ++i) {
+    vector<int> current = states[i];
+    int accepted = -1;
+    for (size_t j = 0; j < dfa_list.size() && accepted < 0; ++j) {
+      if (current[j] >= 0 && dfa_list[j].GetStates()[current[j]])
+        accepted = static_cast<int>(j);
+    }
+    accept.push_back(accepted);
+    vector<int> tran(128, -1);
+    for (int c = 0; c < 128; ++c) {
+      vector<int> target(dfa_list.size(), -1);
+      bool alive = false;
+      for (size_t j = 0; j < dfa_list.size(); ++j) {
+        if (current[j] < 0)
+          continue;
+        const auto &tr = dfa_list[j].GetTransition()[current[j]];
+        if (auto it = tr.find(static_cast<char>(c)); it != tr.end()) {
+          target[j] = it->second;
+          alive = true;
+        }
+      }
+      if (!alive)
+        continue;
+      auto [it, inserted] = state_id.emplace(target, static_cast<int>(states.size()));
+      if (inserted)
+        states.push_back(target);
+      tran[c] = it->second;
+    }
+    transition.push_back(move(tran));
+  }
+  return {transition, accept};
+}
+
+bool check(const MergedDfaModel &merged, const vector<string> &rules) {
+  vector<DfaModel> dfa_list;
+  for (const auto &r : rules) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+  }
+  auto [transition, accept] = reference_merge(dfa_list);
+  bool same = transition == merged.GetTransition() &&
+              accept == merged.GetAcceptStates();
+  cout << boolalpha << same << " (states=" << accept.size()
+       << ", rederived=" << merged.GetRederivedCount() << ")" << endl;
+  return same;
+}
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<string> rules = regex_strings;
+  vector<DfaModel> dfa_list;
+  for (const auto &r : rules) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+  }
+  MergedDfaModel merged(dfa_list);
+  bool ok = check(merged, rules);
+
+  // 替换一条规则
+  rules[2] = R"([0-9]+(\.)[0-9]*)";
+  merged.ReplaceRule(2, RegEx(rules[2]).GetDfaModel());
+  ok = check(merged, rules) && ok;
+
+  // 在标识符之前插入关键字
+  rules.insert(rules.begin() + 3, R"((while))");
+  merged.InsertRule(3, RegEx(rules[3]).GetDfaModel());
+  ok = check(merged, rules) && ok;
+
+  // 末尾追加
+  rules.emplace_back(R"(.)");
+  merged.AddRule(RegEx(rules.back()).GetDfaModel());
+  ok = check(merged, rules) && ok;
+
+  // 删除规则
+  rules.erase(rules.begin());
+  merged.RemoveRule(0);
+  ok = check(merged, rules) && ok;
+
+  rules.erase(rules.begin() + 3);
+  merged.RemoveRule(3);
+  ok = check(merged, rules) && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test9.cpp
+ * @brief 测试 SeuLex（mmap 输入）与 Stream2TokenPipe 的识别结果一致，并比较吞吐量
+ */
+
+#include "sly/FaModel.h"
+#include "sly/RegEx.h"
+#include "sly/SeuLex.h"
+#include "sly/Stream2TokenPipe.h"
+#include "spdlog/spdlog.h"
+#include <sly/sly.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using sly::core::lexical::DfaModel;
+using sly::core::lexical::RegEx;
+using sly::runtime::SeuLex;
+using sly::runtime::Stream2TokenPipe;
+using namespace std;
+
+vector<string> regex_strings = {
+    R"((int))",
+    R"((return))",
+    R"([0-9]+)",
+    R"([a-zA-Z_]([a-zA-Z_]|[0-9])*)",
+    R"(L?"(\\.|[^\\"\n\r])*")",
+    R"(;)",
+    R"(\()",
+    R"(\))",
+    R"(\{)",
+    R"(\})",
+    R"(,)",
+    R"(=)",
+    R"(\+)",
+    R"(( |\t|\n|\r))",
+};
+
+int main() {
+  spdlog::set_level(spdlog::level::warn);
+  vector<DfaModel> dfa_list;
+  vector<Token> tokens;
+  for (const auto &r : regex_strings) {
+    dfa_list.push_back(RegEx(r).GetDfaModel());
+    tokens.push_back(Token::Terminator(r));
+  }
+  auto end_token = Token::Terminator("end");
+  auto [transition, accept] = DfaModel::Merge(dfa_list);
+
+  string path = "test9.in";
+  {
+    ofstream ofs(path);
+    for (int i = 0; i < 20000; ++i) {
+      ofs << "int main() {\n  printf(\"Hello World!\", " << i
+          << ");\n  return x1 + 0;\n}\n";
+    }
+  }
+
+  // Stream2TokenPipe
+  ifstream ifs(path);
+  stringstream ss;
+  ss << ifs.rdbuf();
+  Stream2TokenPipe s2ppl(transition, accept, tokens, end_token);
+  vector<tuple<Token, string, int, int>> expect;
+  auto t0 = chrono::steady_clock::now();
+  while (true) {
+    auto tok = s2ppl.Defer(ss);
+    if (tok == end_token) break;
+    expect.emplace_back(tok, s2ppl.buffer_, s2ppl.token_begin_row_,
+                        s2ppl.token_begin_col_);
+  }
+  auto t1 = chrono::steady_clock::now();
+
+  // SeuLex
+  SeuLex lexer(transition, accept, tokens, end_token);
+  lexer.Open(path);
+  lexer.Process();
+  auto t2 = chrono::steady_clock::now();
+
+  bool same = expect.size() == lexer.GetLexemes().size();
+  for (size_t i = 0; same && i < expect.size(); ++i) {
+    const auto &lexeme = lexer.GetLexemes()[i];
+    same = get<0>(expect[i]) == lexer.GetToken(lexeme) &&
+           get<1>(expect[i]) == lexer.Text(lexeme);
+  }
+  cout << boolalpha << "tokens equal: " << same << " ("
+       << lexer.GetLexemes().size() << " tokens)" << endl;
+
+  // 行列号：第二行的 printf 位于 2:3
+  size_t idx = 0;
+  while (lexer.Text(lexer.GetLexemes()[idx]) != "printf") ++idx;
+  auto [row, col] = lexer.Locate(lexer.GetLexemes()[idx].offset);
+  cout << "locate: " << (row == 2 && col == 3) << endl;
+
+  // input / unput
+  lexer.SetInput("ab");
+  char c = lexer.Input();
+  lexer.Unput(c);
+  cout << "input/unput: " << (lexer.Input() == 'a' && lexer.Input() == 'b' &&
+                              lexer.Input() == 0)
+       << endl;
+
+  // 退回与读到的不同的字符
+  lexer.SetInput("int x;");
+  lexer.Lex();
+  lexer.Input();
+  lexer.Input();
+  lexer.Unput('y');
+  lexer.Unput('_');
+  auto lexeme = lexer.Lex();
+  cout << "unput other: " << (lexer.Text(lexeme) == "_y") << endl;
+
+  // 对映射的文件退回不同的字符后，之前保存的词文仍然可读
+  lexer.Open(path);
+  auto saved = lexer.Text(lexer.Lex());
+  lexer.Input();
+  lexer.Unput('X');
+  cout << "saved lexeme after unput: " << (saved == "int") << endl;
+
+  using ms = chrono::duration<double, milli>;
+  cout << "Stream2TokenPipe: " << ms(t1 - t0).count() << " ms" << endl;
+  cout << "SeuLex:           " << ms(t2 - t1).count() << " ms" << endl;
+  remove(path.c_str());
+  return 0;
+}